@@ -0,0 +1,17 @@
+#include "templated_main.hpp"
+
+#include <app/detail/request_handler.hpp>
+#include <app/message_handlers/reply_collector.hpp>
+
+#include <model/reflection/message.h>
+
+int main(int argc, char* argv[]) {
+    const std::size_t reference_threshold = 1024;
+    auto on_message_factory = make_reply_collector_factory([=](model::Messages m) {
+        return make_content_with_value(std::move(m), [=](const model::Messages& v) {
+            return serializeToCborRope(v, reference_threshold);
+        });
+    }, "application/cbor", true);
+    auto rh = make_request_handler( std::move(on_message_factory) );
+    return templated_main( argc, argv, std::move(rh) );
+}
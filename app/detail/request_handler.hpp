@@ -5,6 +5,9 @@
 
 #include <http/server/request.hpp>
 #include <model/data/mailbox.h>
+#include <model/reflection/message.h>
+
+#include <yamail/data/reflection/field_mask.h>
 
 namespace http {
 namespace server {
@@ -21,7 +24,8 @@ public:
     request_handler(request_handler&& other);
 
     /// Handle a request and produce a reply.
-    /// ConnectionHandler will be first argument to OnMessageFactory invocation".
+    /// ConnectionHandler will be first argument to OnMessageFactory invocation",
+    /// the field mask of the "fields" query parameter is the second one.
     template<typename ConnectionHandler>
     void handle_request(const request& req, ConnectionHandler&& handler);
 
@@ -34,6 +38,11 @@ private:
     /// Perform URL-decoding on a string. Returns false if the encoding was
     /// invalid.
     static bool url_decode(const std::string& in, std::string& out);
+
+    /// Find the decoded value of the query parameter. Returns false if the
+    /// encoding was invalid.
+    static bool query_param(const std::string& query, const std::string& name,
+            std::string& out);
 };
 
 template <typename OnMF>
@@ -18,9 +18,25 @@ request_handler<OnMF>::request_handler(request_handler&& other) :
 template<typename OnMF>
 template<typename ConnectionHandler>
 void request_handler<OnMF>::handle_request(const request& req, ConnectionHandler&& handler) {
-    // Decode url to path.
+    // Decode url to path and query.
+    const std::string::size_type query_pos = req.uri.find('?');
     std::string request_path;
-    if (!url_decode(req.uri, request_path)) {
+    if (!url_decode(req.uri.substr(0, query_pos), request_path)) {
+        handler(reply::stock_reply(reply::bad_request));
+        return;
+    }
+
+    // Compile the fields to serialize, all of them by default.
+    std::string fields;
+    if (query_pos != std::string::npos
+            && !query_param(req.uri.substr(query_pos + 1), "fields", fields)) {
+        handler(reply::stock_reply(reply::bad_request));
+        return;
+    }
+    yamail::data::reflection::FieldMask mask;
+    try {
+        mask = yamail::data::reflection::parseFieldMask<model::Message>(fields);
+    } catch (const yamail::data::reflection::FieldMaskError&) {
         handler(reply::stock_reply(reply::bad_request));
         return;
     }
@@ -32,13 +48,18 @@ void request_handler<OnMF>::handle_request(const request& req, ConnectionHandler
         return;
     }
 
+    // Push the projection down if the reply honours it, the masked out
+    // fields are not loaded at all then.
+    const model::MessageFields message_fields = f.honours_field_mask()
+            ? messageFields(mask) : model::MessageFields();
+
     //Dispatch request
     if (request_path == "/messages") {
-        mailbox.getMessages( f(std::forward<ConnectionHandler>(handler)) );
+        mailbox.getMessages( message_fields, f(std::forward<ConnectionHandler>(handler), std::move(mask)) );
     } else if (request_path == "/messages/id") {
-        mailbox.getMessages( model::Message::Id(), f(std::forward<ConnectionHandler>(handler)) );
+        mailbox.getMessages( model::Message::Id(), message_fields, f(std::forward<ConnectionHandler>(handler), std::move(mask)) );
     } else if (request_path == "/messages/recipient") {
-        mailbox.getMessages( model::Recipient(), f(std::forward<ConnectionHandler>(handler)) );
+        mailbox.getMessages( model::Recipient(), message_fields, f(std::forward<ConnectionHandler>(handler), std::move(mask)) );
     } else {
         handler(reply::stock_reply(reply::not_found));
     }
@@ -71,6 +92,26 @@ bool request_handler<OnMF>::url_decode(const std::string& in, std::string& out)
     return true;
 }
 
+template <typename OnMF>
+bool request_handler<OnMF>::query_param(const std::string& query, const std::string& name,
+        std::string& out) {
+    out.clear();
+    std::string::size_type begin = 0;
+    while (begin <= query.size()) {
+        std::string::size_type end = query.find('&', begin);
+        if (end == std::string::npos) {
+            end = query.size();
+        }
+        if (query.compare(begin, name.size(), name) == 0
+                && begin + name.size() < end && query[begin + name.size()] == '=') {
+            const std::string::size_type value = begin + name.size() + 1;
+            return url_decode(query.substr(value, end - value), out);
+        }
+        begin = end + 1;
+    }
+    return true;
+}
+
 } // namespace server
 } // namespace http
 
@@ -36,14 +36,11 @@ void print(std::ostream& os, const model::Message& m) {
 template<typename Arr>
 void print_array(std::ostream& os, Arr& array) {
     os << "[";
-    auto it = array.begin();
-    while( true ) {
-        print( os, *it );
-        if( ++it != array.end() ) {
+    for( auto it = array.begin(); it != array.end(); ++it ) {
+        if( it != array.begin() ) {
             os << ", ";
-        } else {
-            break;
         }
+        print( os, *it );
     }
     os << "]";
 }
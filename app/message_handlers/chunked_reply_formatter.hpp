@@ -4,18 +4,20 @@
 #include <http/server/reply.hpp>
 #include <model/data/message.h>
 
+#include <yamail/data/reflection/reflection.h>
+
 #include <boost/optional.hpp>
 
 using namespace http::server;
 
-inline reply ok_reply() {
+inline reply ok_reply(const char* content_type = "application/json") {
     reply rep;
     rep.status = reply::ok;
     rep.headers.resize(2);
     rep.headers[0].name = "Transfer-Encoding";
     rep.headers[0].value = "chunked";
     rep.headers[1].name = "Content-Type";
-    rep.headers[1].value = "application/json";
+    rep.headers[1].value = content_type;
     return rep;
 }
 
@@ -24,10 +26,14 @@ template<typename OnChunk, typename Serializer>
 struct chunked_reply_formatter {
     OnChunk handler;
     Serializer serializer;
+    const char* content_type;
+    yamail::data::reflection::FieldMask mask;
     bool headers_sent;
 
-    chunked_reply_formatter(OnChunk h, Serializer s)
-        : handler(std::move(h)), serializer(std::move(s)), headers_sent(false) {}
+    chunked_reply_formatter(OnChunk h, Serializer s, const char* content_type,
+            yamail::data::reflection::FieldMask mask)
+        : handler(std::move(h)), serializer(std::move(s)), content_type(content_type),
+          mask(std::move(mask)), headers_sent(false) {}
 
     template<typename Continuation>
     void operator()(
@@ -39,40 +45,55 @@ struct chunked_reply_formatter {
             if (e) {
                 handler(reply::stock_reply(reply::internal_server_error));
             } else {
-                handler(ok_reply());
+                handler(ok_reply(content_type));
             }
         }
         if (e) {
             handler();
         } else {
             if(m) {
-                handler(serializer(std::move(m)), std::forward<Continuation>(cont));
+                handler(serialize(std::move(m)), std::forward<Continuation>(cont));
             } else {
-                handler(serializer(std::move(m)), handler);
+                handler(serialize(std::move(m)), handler);
             }
         }
     }
+
+    auto serialize(boost::optional<model::Message> m) -> decltype(serializer(std::move(m))) {
+        const yamail::data::reflection::FieldMaskScope scope(mask);
+        return serializer(std::move(m));
+    }
 };
 
 template<typename Serializer>
 struct chunked_reply_formatter_factory {
-    chunked_reply_formatter_factory(Serializer s) : s(std::move(s)) {}
+    chunked_reply_formatter_factory(Serializer s, const char* content_type, bool honours_field_mask)
+        : s(std::move(s)), content_type(content_type), honours_field_mask_(honours_field_mask) {}
+
+    /// See reply_collector_factory::honours_field_mask.
+    bool honours_field_mask() const { return honours_field_mask_; }
 
     template<typename OnMessage>
     using result_type = chunked_reply_formatter<OnMessage, Serializer>;
 
+    /// The mask selects the message fields the reflection serializers write.
     template<typename OnMessage>
-    result_type<OnMessage> operator()(OnMessage&& h) {
-        return result_type<OnMessage>(std::forward<OnMessage>(h), s);
+    result_type<OnMessage> operator()(OnMessage&& h,
+            yamail::data::reflection::FieldMask mask = yamail::data::reflection::FieldMask()) {
+        return result_type<OnMessage>(std::forward<OnMessage>(h), s, content_type, std::move(mask));
     }
 
 private:
     Serializer s;
+    const char* content_type;
+    bool honours_field_mask_;
 };
 
+/// honours_field_mask as for make_reply_collector_factory.
 template<typename S>
-chunked_reply_formatter_factory<S> make_chunked_reply_formatter_factory(S&& serializer) {
-    return chunked_reply_formatter_factory<S>(std::forward<S>(serializer));
+chunked_reply_formatter_factory<S> make_chunked_reply_formatter_factory(S&& serializer,
+        const char* content_type = "application/json", bool honours_field_mask = false) {
+    return chunked_reply_formatter_factory<S>(std::forward<S>(serializer), content_type, honours_field_mask);
 }
 
 
@@ -0,0 +1,110 @@
+#ifndef APP_MESSAGE_HANDLERS_POOLED_OUTPUT_STREAM_HPP_
+#define APP_MESSAGE_HANDLERS_POOLED_OUTPUT_STREAM_HPP_
+
+#include <memory>
+#include <vector>
+
+#include <google/protobuf/io/zero_copy_stream.h>
+
+/// Fixed size blocks shared by the replies. A reply returns its blocks when
+/// it has been sent, at most max_free blocks are kept for the next ones.
+/// The server runs a single io_service thread, so there is no locking.
+class buffer_pool {
+public:
+    using block = std::unique_ptr<char[]>;
+
+    explicit buffer_pool(std::size_t block_size = 256 * 1024, std::size_t max_free = 64)
+        : block_size_(block_size), max_free_(max_free) {}
+
+    std::size_t block_size() const { return block_size_; }
+
+    block acquire() {
+        if (free_.empty()) {
+            return block(new char[block_size_]);
+        }
+        block retval = std::move(free_.back());
+        free_.pop_back();
+        return retval;
+    }
+
+    void release(block b) {
+        if (free_.size() < max_free_) {
+            free_.push_back(std::move(b));
+        }
+    }
+
+private:
+    std::size_t block_size_;
+    std::size_t max_free_;
+    std::vector<block> free_;
+};
+
+/// Content made of pooled blocks, each one filled up to its own size since a
+/// block may be backed up before the next one is taken. It is sent by
+/// a gather write via assign_content.
+class pooled_buffers {
+public:
+    explicit pooled_buffers(std::shared_ptr<buffer_pool> pool) : pool_(std::move(pool)) {}
+
+    pooled_buffers(pooled_buffers&&) = default;
+    pooled_buffers& operator=(pooled_buffers&&) = delete;
+
+    ~pooled_buffers() {
+        if (pool_) {
+            for (auto& b : blocks_) {
+                pool_->release(std::move(b));
+            }
+        }
+    }
+
+    template<typename ConstBuffer>
+    std::vector<ConstBuffer> buffers() const {
+        std::vector<ConstBuffer> retval;
+        retval.reserve(blocks_.size());
+        for (std::size_t i = 0; i < blocks_.size(); ++i) {
+            if (sizes_[i]) {
+                retval.emplace_back(blocks_[i].get(), sizes_[i]);
+            }
+        }
+        return retval;
+    }
+
+private:
+    friend class pooled_output_stream;
+
+    std::shared_ptr<buffer_pool> pool_;
+    std::vector<buffer_pool::block> blocks_;
+    std::vector<std::size_t> sizes_;
+};
+
+/// Serializes a protobuf message right into the blocks of pooled_buffers,
+/// e.g. by SerializeToZeroCopyStream.
+class pooled_output_stream : public google::protobuf::io::ZeroCopyOutputStream {
+public:
+    explicit pooled_output_stream(pooled_buffers& out) : out_(out) {}
+
+    bool Next(void** data, int* size) override {
+        auto& pool = *out_.pool_;
+        out_.blocks_.push_back(pool.acquire());
+        out_.sizes_.push_back(pool.block_size());
+        byte_count_ += pool.block_size();
+        *data = out_.blocks_.back().get();
+        *size = static_cast<int>(pool.block_size());
+        return true;
+    }
+
+    void BackUp(int count) override {
+        out_.sizes_.back() -= static_cast<std::size_t>(count);
+        byte_count_ -= static_cast<std::size_t>(count);
+    }
+
+    int64_t ByteCount() const override {
+        return static_cast<int64_t>(byte_count_);
+    }
+
+private:
+    pooled_buffers& out_;
+    std::size_t byte_count_ = 0;
+};
+
+#endif /* APP_MESSAGE_HANDLERS_POOLED_OUTPUT_STREAM_HPP_ */
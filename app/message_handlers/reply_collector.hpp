@@ -4,25 +4,68 @@
 #include <http/server/reply.hpp>
 #include <model/data/message.h>
 
+#include <yamail/data/reflection/reflection.h>
+
+#include <memory>
+
 #include <boost/optional.hpp>
 
-inline void fill_ok_reply(reply& rep) {
+inline void fill_ok_reply(reply& rep, const char* content_type = "application/json") {
     rep.status = reply::ok;
     rep.headers.resize(2);
     rep.headers[0].name = "Content-Length";
-    rep.headers[0].value = std::to_string(rep.content.size());
+    rep.headers[0].value = std::to_string(rep.content_size());
     rep.headers[1].name = "Content-Type";
-    rep.headers[1].value = "application/json";
+    rep.headers[1].value = content_type;
+}
+
+inline void assign_content(reply& rep, std::string content) {
+    rep.content = std::move(content);
+}
+
+/// Content with the buffers<const_buffer>() sequence, e.g. json::Rope, is
+/// sent by a gather write without flattening.
+template<typename Content>
+inline void assign_content(reply& rep, Content content) {
+    const auto owner = std::make_shared<Content>(std::move(content));
+    rep.content_buffers = owner->template buffers<boost::asio::const_buffer>();
+    rep.content_owner = owner;
+}
+
+/// Content referencing the memory of the value it was made of, e.g. a
+/// json::Rope with the strings of the messages. The value is kept alive
+/// together with the content until the reply is sent.
+template<typename Value, typename Content>
+struct content_with_value {
+    std::shared_ptr<const Value> value;
+    Content content;
+
+    template<typename ConstBuffer>
+    std::vector<ConstBuffer> buffers() const {
+        return content.template buffers<ConstBuffer>();
+    }
+};
+
+template<typename Value, typename Serialize>
+auto make_content_with_value(Value value, Serialize serialize)
+        -> content_with_value<Value, decltype(serialize(value))> {
+    auto v = std::make_shared<const Value>(std::move(value));
+    auto content = serialize(*v);
+    return content_with_value<Value, decltype(serialize(value))>{std::move(v), std::move(content)};
 }
 
 template<typename OnReply, typename Serializer>
 struct reply_collector {
     OnReply handler;
     Serializer serializer;
+    const char* content_type;
+    yamail::data::reflection::FieldMask mask;
     model::Messages messages;
 
-    reply_collector(OnReply h, Serializer s)
-        : handler(std::move(h)), serializer(std::move(s)) {}
+    reply_collector(OnReply h, Serializer s, const char* content_type,
+            yamail::data::reflection::FieldMask mask)
+        : handler(std::move(h)), serializer(std::move(s)), content_type(content_type),
+          mask(std::move(mask)) {}
 
     template<typename Continuation>
     void operator()(
@@ -33,8 +76,11 @@ struct reply_collector {
             handler(reply::stock_reply(reply::internal_server_error));
         } else if (!m) {
             reply rep;
-            rep.content = serializer(std::move(messages));
-            fill_ok_reply(rep);
+            {
+                const yamail::data::reflection::FieldMaskScope scope(mask);
+                assign_content(rep, serializer(std::move(messages)));
+            }
+            fill_ok_reply(rep, content_type);
             handler(rep);
         } else {
             messages.push_back(std::move(*m));
@@ -45,23 +91,36 @@ struct reply_collector {
 
 template<typename Serializer>
 struct reply_collector_factory {
-    reply_collector_factory(Serializer s) : s(std::move(s)) {}
+    reply_collector_factory(Serializer s, const char* content_type, bool honours_field_mask)
+        : s(std::move(s)), content_type(content_type), honours_field_mask_(honours_field_mask) {}
+
+    /// Whether the serializer writes the fields of the mask only, so the
+    /// mailbox need not load the other ones.
+    bool honours_field_mask() const { return honours_field_mask_; }
 
     template<typename OnReply>
     using result_type = reply_collector<OnReply, Serializer>;
 
+    /// The mask selects the message fields the reflection serializers write.
     template<typename OnReply>
-    result_type<OnReply> operator()(OnReply&& h) {
-        return result_type<OnReply>(std::forward<OnReply>(h), s);
+    result_type<OnReply> operator()(OnReply&& h,
+            yamail::data::reflection::FieldMask mask = yamail::data::reflection::FieldMask()) {
+        return result_type<OnReply>(std::forward<OnReply>(h), s, content_type, std::move(mask));
     }
 
 private:
     Serializer s;
+    const char* content_type;
+    bool honours_field_mask_;
 };
 
+/// A serializer made of the reflection honours the field mask of a request,
+/// so the fields out of the mask are not loaded from the mailbox at all.
+/// A handwritten one writes every field, so it must get them all.
 template<typename S>
-reply_collector_factory<S> make_reply_collector_factory(S&& serializer) {
-    return reply_collector_factory<S>(std::forward<S>(serializer));
+reply_collector_factory<S> make_reply_collector_factory(S&& serializer,
+        const char* content_type = "application/json", bool honours_field_mask = false) {
+    return reply_collector_factory<S>(std::forward<S>(serializer), content_type, honours_field_mask);
 }
 
 
@@ -2,35 +2,39 @@
 
 #include <app/detail/request_handler.hpp>
 #include <app/message_handlers/reply_collector.hpp>
+#include <app/message_handlers/pooled_output_stream.hpp>
 
 #include <model/protobuf/model.pb.h>
 
-#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/arena.h>
+
+#include <stdexcept>
 
 using namespace yreflection::model;
 
-void fill(Email& proto_email, const model::Email& email) {
-    proto_email.set_address(email.address);
-    proto_email.set_name(email.name);
+/// The string is moved into the arena string of the field, its data is not
+/// copied.
+#define MOVE_STR_TO_PROTO(proto, obj, field) \
+    proto.set_##field( std::move(obj.field) );
+
+void fill(Email& proto_email, model::Email&& email) {
+    MOVE_STR_TO_PROTO(proto_email, email, address);
+    MOVE_STR_TO_PROTO(proto_email, email, name);
 }
 
 void fill(Recipient& proto_rcpt, model::Recipient&& rcpt) {
     proto_rcpt.set_type( rcpt.type() );
 
     Email* proto_email = proto_rcpt.mutable_email();
-    fill(*proto_email, rcpt.email());
+    fill(*proto_email, std::move(rcpt.email_));
 }
 
-#define MOVE_STR_TO_PROTO(proto, obj, field) \
-    std::string* heaped_##field = new std::string(); \
-    heaped_##field->swap(obj.field); \
-    proto.set_allocated_##field( heaped_##field );
-
 void fill(Message& proto_msg, model::Message&& msg) {
     MOVE_STR_TO_PROTO(proto_msg, msg, id);
     MOVE_STR_TO_PROTO(proto_msg, msg, body);
     MOVE_STR_TO_PROTO(proto_msg, msg, subject);
 
+    proto_msg.mutable_recipients()->Reserve(static_cast<int>(msg.recipients.size()));
     for( auto&& r : msg.recipients ) {
         Recipient* proto_r = proto_msg.add_recipients();
         fill(*proto_r, std::move(r));
@@ -38,18 +42,57 @@ void fill(Message& proto_msg, model::Message&& msg) {
 }
 
 void fill(Messages& proto_msgs, model::Messages&& msgs) {
+    proto_msgs.mutable_message()->Reserve(static_cast<int>(msgs.size()));
     for( auto&& m : msgs ) {
         Message* proto_m = proto_msgs.add_message();
         fill(*proto_m, std::move(m));
     }
 }
 
+/// The arena the messages of a reply are built on. Its initial block is
+/// kept by Reset(), so the replies reuse it instead of allocating every
+/// message, recipient and string separately.
+class reply_arena {
+public:
+    explicit reply_arena(std::size_t block_size = 1024 * 1024)
+        : initial_block_(new char[block_size]), arena_(options(initial_block_.get(), block_size)) {}
+
+    google::protobuf::Arena& get() { return arena_; }
+
+    void reset() { arena_.Reset(); }
+
+private:
+    static google::protobuf::ArenaOptions options(char* block, std::size_t size) {
+        google::protobuf::ArenaOptions retval;
+        retval.initial_block = block;
+        retval.initial_block_size = size;
+        retval.start_block_size = size;
+        retval.max_block_size = size;
+        return retval;
+    }
+
+    std::unique_ptr<char[]> initial_block_;
+    google::protobuf::Arena arena_;
+};
+
 int main(int argc, char* argv[]) {
-    auto on_message_factory = make_reply_collector_factory([](model::Messages&& msgs) {
-        Messages proto_msgs;
-        fill(proto_msgs, std::move(msgs));
-        return proto_msgs.SerializeAsString();
-    });
+    auto arena = std::make_shared<reply_arena>();
+    auto pool = std::make_shared<buffer_pool>();
+    auto on_message_factory = make_reply_collector_factory([arena, pool](model::Messages&& msgs) {
+        // The arena drops the messages of the previous reply here rather than
+        // after the serialization, so a failed reply cannot keep them.
+        arena->reset();
+        pooled_buffers content(pool);
+        {
+            auto proto_msgs = google::protobuf::Arena::CreateMessage<Messages>(&arena->get());
+            fill(*proto_msgs, std::move(msgs));
+            pooled_output_stream out(content);
+            if (!proto_msgs->SerializeToZeroCopyStream(&out)) {
+                throw std::runtime_error("failed to serialize the protobuf reply");
+            }
+        }
+        return content;
+    }, "application/x-protobuf");
     auto rh = make_request_handler( std::move(on_message_factory) );
     return templated_main( argc, argv,std::move(rh) );
 }
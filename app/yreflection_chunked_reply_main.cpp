@@ -12,7 +12,9 @@ int main(int argc, char* argv[]) {
     auto on_message_factory = make_chunked_reply_formatter_factory(
             yamail::data::serialization::toChunkedJson<model::Message>(
                 yamail::data::reflection::namedItemTag(rootName)
-            )
+            ),
+            "application/json",
+            true
     );
     auto rh = make_request_handler( std::move(on_message_factory) );
     return templated_main<chunked_connection>( argc, argv, std::move(rh) );
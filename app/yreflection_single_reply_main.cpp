@@ -6,9 +6,12 @@
 #include <model/reflection/message.h>
 
 int main(int argc, char* argv[]) {
-    auto on_message_factory = make_reply_collector_factory([](const model::Messages& m) {
-        return serialize(m).str();
-    });
+    const std::size_t reference_threshold = 1024;
+    auto on_message_factory = make_reply_collector_factory([=](model::Messages m) {
+        return make_content_with_value(std::move(m), [=](const model::Messages& v) {
+            return serializeToRope(v, reference_threshold);
+        });
+    }, "application/json", true);
     auto rh = make_request_handler( std::move(on_message_factory) );
     return templated_main( argc, argv, std::move(rh) );
 }
@@ -1,12 +1,16 @@
+#include <algorithm>
 #include <iostream>
 #include <istream>
 #include <ostream>
 #include <string>
 #include <thread>
+#include <vector>
+#include <boost/algorithm/string.hpp>
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
 #include <boost/lexical_cast.hpp>
 #include "stats.h"
+#include "delimited_messages_decoder.h"
 
 using boost::asio::ip::tcp;
 
@@ -44,6 +48,8 @@ private:
   }
 
   void request() {
+    decoder_.reset();
+    chunked_ = false;
     std::ostream request_stream(&request_);
     request_stream << "GET " << path_ << " HTTP/1.0\r\n";
     request_stream << "Host: " << server_ << "\r\n";
@@ -119,12 +125,49 @@ private:
     }
   }
 
-  void handle_header(const std::string& ) {
+  /// A chunked stream of delimited protobuf records is decoded as it comes.
+  /// The header names and values are matched in any case, with any spaces
+  /// around them.
+  void handle_header(const std::string& header) {
+    const auto colon = header.find(':');
+    if (colon == std::string::npos) {
+      return;
+    }
+    const std::string name = boost::algorithm::trim_copy(header.substr(0, colon));
+    const std::string value = boost::algorithm::trim_copy(header.substr(colon + 1));
+    if (boost::algorithm::iequals(name, "Transfer-Encoding")) {
+      chunked_ = boost::algorithm::iequals(value, "chunked");
+    } else if (boost::algorithm::iequals(name, "Content-Type") && is_delimited_protobuf(value)) {
+      decoder_.reset(new delimited_messages_decoder);
+    }
+  }
 
+  /// The application/x-protobuf media type with the delimited=true parameter.
+  static bool is_delimited_protobuf(const std::string& content_type) {
+    std::vector<std::string> parts;
+    boost::algorithm::split(parts, content_type, boost::algorithm::is_any_of(";"));
+    if (!boost::algorithm::iequals(boost::algorithm::trim_copy(parts.front()), "application/x-protobuf")) {
+      return false;
+    }
+    return std::any_of(parts.begin() + 1, parts.end(), [] (const std::string& parameter) {
+      const auto equals = parameter.find('=');
+      return equals != std::string::npos
+          && boost::algorithm::iequals(boost::algorithm::trim_copy(parameter.substr(0, equals)), "delimited")
+          && boost::algorithm::iequals(boost::algorithm::trim_copy(parameter.substr(equals + 1)), "true");
+    });
   }
 
   void handle_response_part() {
     if (response_.size() > 0) {
+      if (decoder_ && chunked_) {
+        for (const auto& b : response_.data()) {
+          if (!decoder_->consume(boost::asio::buffer_cast<const char*>(b), boost::asio::buffer_size(b))) {
+            std::cout << "Invalid protobuf stream\n";
+            decoder_.reset();
+            break;
+          }
+        }
+      }
       stats_sample_->adjust(response_.size());
       response_.consume(response_.size());
     }
@@ -160,6 +203,9 @@ private:
     } else if (err != boost::asio::error::eof) {
       std::cout << "Error: " << err << "\n";
     } else {
+      if (decoder_ && chunked_ && !decoder_->finished()) {
+        std::cout << "Incomplete protobuf stream\n";
+      }
       error_code ec;
       socket_.close (ec);
       request();
@@ -173,6 +219,8 @@ private:
   boost::asio::streambuf response_;
   profiling::stats& stats_;
   std::unique_ptr<profiling::stats_sample> stats_sample_;
+  std::unique_ptr<delimited_messages_decoder> decoder_;
+  bool chunked_ = false;
   std::string server_;
   std::string path_;
 };
@@ -0,0 +1,138 @@
+#ifndef _DELIMITED_MESSAGES_DECODER_H_
+#define _DELIMITED_MESSAGES_DECODER_H_
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+
+#include <model/reflection/message.h>
+#include <yamail/data/deserialization/protobuf_reader.h>
+
+/// Decodes a chunked body of length delimited model::Message records, the
+/// stream of the protobuf chunked reply server. A record may span chunks,
+/// the records within a chunk are read right from the received data.
+class delimited_messages_decoder
+{
+public:
+  /// Consumes the next part of the body, returns false on malformed data.
+  bool consume(const char* data, std::size_t size) {
+    const char* const end = data + size;
+    while (data != end) {
+      switch (state_) {
+      case chunk_size:
+        if (*data == '\r') {
+          state_ = chunk_size_lf;
+        } else if (!add_size_digit(*data)) {
+          return false;
+        }
+        ++data;
+        break;
+      case chunk_size_lf:
+        if (*data++ != '\n') {
+          return false;
+        }
+        state_ = size_ ? chunk_data : trailer_cr;
+        break;
+      case chunk_data: {
+        const std::size_t n = std::min(size_, static_cast<std::size_t>(end - data));
+        if (!read_records(data, n)) {
+          return false;
+        }
+        data += n;
+        size_ -= n;
+        if (!size_) {
+          state_ = chunk_data_cr;
+        }
+        break;
+      }
+      case chunk_data_cr:
+      case trailer_cr:
+        if (*data++ != '\r') {
+          return false;
+        }
+        state_ = state_ == chunk_data_cr ? chunk_data_lf : trailer_lf;
+        break;
+      case chunk_data_lf:
+        if (*data++ != '\n') {
+          return false;
+        }
+        state_ = chunk_size;
+        break;
+      case trailer_lf:
+        if (*data++ != '\n' || !pending_.empty()) {
+          return false;
+        }
+        state_ = done;
+        break;
+      case done:
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool finished() const { return state_ == done; }
+
+  std::size_t messages() const { return messages_; }
+
+private:
+  enum state_type {
+    chunk_size,
+    chunk_size_lf,
+    chunk_data,
+    chunk_data_cr,
+    chunk_data_lf,
+    trailer_cr,
+    trailer_lf,
+    done
+  };
+
+  bool add_size_digit(char c) {
+    const char* const digits = "0123456789abcdef";
+    const char* d = std::char_traits<char>::find(digits, 16, static_cast<char>(std::tolower(c)));
+    if (!d) {
+      return false;
+    }
+    size_ = size_ * 16 + static_cast<std::size_t>(d - digits);
+    return true;
+  }
+
+  bool read_records(const char* data, std::size_t size) {
+    if (!pending_.empty()) {
+      pending_.append(data, size);
+      const char* end = read_records(pending_.data(), pending_.data() + pending_.size());
+      if (!end) {
+        return false;
+      }
+      pending_.erase(0, static_cast<std::size_t>(end - pending_.data()));
+      return true;
+    }
+    const char* end = read_records(data, data + size);
+    if (!end) {
+      return false;
+    }
+    pending_.assign(end, data + size);
+    return true;
+  }
+
+  /// Returns the end of the complete records or nullptr on malformed data.
+  const char* read_records(const char* data, const char* end) {
+    try {
+      while (const char* next = yamail::data::deserialization::fromDelimitedProtobuf(data, end, message_)) {
+        data = next;
+        ++messages_;
+      }
+    } catch (const yamail::data::deserialization::ProtobufReaderError&) {
+      return nullptr;
+    }
+    return data;
+  }
+
+  state_type state_ = chunk_size;
+  std::size_t size_ = 0;
+  std::string pending_;
+  model::Message message_;
+  std::size_t messages_ = 0;
+};
+
+#endif /* _DELIMITED_MESSAGES_DECODER_H_ */
@@ -48,7 +48,7 @@ void chunked_connection<RH>::do_read() {
 template<typename RH>
 template<typename Buffer, typename Cont>
 void chunked_connection<RH>::operator()(Buffer chunk, Cont&& cont) {
-    const char crlf[] = { '\r', '\n' };
+    static const char crlf[] = { '\r', '\n' };
 
     std::vector<boost::asio::const_buffer> buffers;
     if( reply_ ) {
@@ -56,8 +56,8 @@ void chunked_connection<RH>::operator()(Buffer chunk, Cont&& cont) {
     }
     std::stringstream ss;
     ss << std::hex << chunk.size();
-    auto chunk_size = ss.str();
-    buffers.push_back( boost::asio::buffer(chunk_size) );
+    chunk_size_ = ss.str();
+    buffers.push_back( boost::asio::buffer(chunk_size_) );
     buffers.push_back( boost::asio::buffer(crlf) );
     buffers.push_back( boost::asio::buffer(&chunk[0], chunk.size()) );
     buffers.push_back( boost::asio::buffer(crlf) );
@@ -95,9 +95,14 @@ std::vector<boost::asio::const_buffer> reply::to_buffers() {
     }
     buffers.push_back(boost::asio::buffer(misc_strings::crlf));
     buffers.push_back(boost::asio::buffer(content));
+    buffers.insert(buffers.end(), content_buffers.begin(), content_buffers.end());
     return buffers;
 }
 
+std::size_t reply::content_size() const {
+    return content.size() + boost::asio::buffer_size(content_buffers);
+}
+
 namespace stock_replies {
 
 const char ok[] = "";
@@ -11,6 +11,7 @@
 #ifndef HTTP_REPLY_HPP
 #define HTTP_REPLY_HPP
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <boost/asio.hpp>
@@ -47,6 +48,14 @@ struct reply {
     /// The content to be sent in the reply.
     std::string content;
 
+    /// The content kept out of the string, e.g. the blocks of a serialized
+    /// reply. It is sent after content, content_owner keeps the memory alive.
+    std::vector<boost::asio::const_buffer> content_buffers;
+    std::shared_ptr<const void> content_owner;
+
+    /// Size of the content and the content buffers together.
+    std::size_t content_size() const;
+
     /// Convert the reply into a vector of buffers. The buffers do not own the
     /// underlying memory blocks, therefore the reply object must remain valid and
     /// not be changed until the write operation has completed.
@@ -55,7 +55,16 @@ public:
      */
     template <typename Handler>
     void getMessages(Handler h) const {
-        impl.getMessages(OnMessageFactory<Handler>{std::move(h)});
+        getMessages(MessageFields(), std::move(h));
+    }
+
+    /**
+     * The overloads with fields are the projection of the query: the messages are passed to
+     * the handler with the requested members only, the rest are left empty.
+     */
+    template <typename Handler>
+    void getMessages(const MessageFields& fields, Handler h) const {
+        impl.getMessages(fields, OnMessageFactory<Handler>{std::move(h)});
     }
 
     /**
@@ -63,7 +72,12 @@ public:
      */
     template <typename Handler>
     void getMessages(const Message::Id& id, Handler h) const {
-        impl.getMessages(id, OnMessageFactory<Handler>{std::move(h)});
+        getMessages(id, MessageFields(), std::move(h));
+    }
+
+    template <typename Handler>
+    void getMessages(const Message::Id& id, const MessageFields& fields, Handler h) const {
+        impl.getMessages(id, fields, OnMessageFactory<Handler>{std::move(h)});
     }
 
     /**
@@ -71,7 +85,12 @@ public:
      */
     template <typename Handler>
     void getMessages(const Recipient& r, Handler h) const {
-        impl.getMessages(r, OnMessageFactory<Handler>{std::move(h)});
+        getMessages(r, MessageFields(), std::move(h));
+    }
+
+    template <typename Handler>
+    void getMessages(const Recipient& r, const MessageFields& fields, Handler h) const {
+        impl.getMessages(r, fields, OnMessageFactory<Handler>{std::move(h)});
     }
 };
 
@@ -132,43 +151,61 @@ inline const std::string & genRandomBody() {
 class DummyImpl {
 public:
 	template <typename OnMessageFactory>
-	void getMessages(OnMessageFactory f) const {
-	    f(Request{getRandom(100, 1000)})();
+	void getMessages(const MessageFields& fields, OnMessageFactory f) const {
+	    f(Request{fields, getRandom(100, 1000)})();
 	}
 
 	template <typename OnMessageFactory>
-	void getMessages(const Message::Id& /*id*/, OnMessageFactory f) const {
-		f(Request())();
+	void getMessages(const Message::Id& /*id*/, const MessageFields& fields, OnMessageFactory f) const {
+		f(Request{fields})();
 	}
 
 	template <typename OnMessageFactory>
-	void getMessages(const Recipient& /*r*/, OnMessageFactory f) const {
-		f(Request{getRandom(1, 10)})();
+	void getMessages(const Recipient& /*r*/, const MessageFields& fields, OnMessageFactory f) const {
+		f(Request{fields, getRandom(1, 10)})();
 	}
 
 	struct Request : boost::asio::coroutine {
+        MessageFields fields;
         std::size_t count;
 
-        Request(std::size_t count = 1) : count(count) {}
+        Request(MessageFields fields, std::size_t count = 1) : fields(fields), count(count) {}
 
 	    template<typename Handler>
 	    void operator()(Handler&& h) {
 
 	        reenter(*this) {
                 for(;count;--count) {
-                    yield h( Message{
-                                Message::Id{"42-100500"},
-                                Message::Subject{"I love you Ozzy!"},
-                                Message::Recipients{
-                                    Recipient{Recipient::Type::from, Email{"Vasya Pupkin", "vasya@yandex.ru"}},
-                                    Recipient{Recipient::Type::to, Email{"Ozzy Osbourne", "ozzy@gmail.com"}},
-                                },
-                                Message::Body{genRandomBody()}
-                            });
+                    yield h( message() );
                 };
                 yield h(optional<Message>());
 	        }
 	    }
+
+        /**
+         * Only the requested members are filled, so the body is not copied
+         * for a header-only listing.
+         */
+        Message message() const {
+            using F = MessageFields;
+            Message retval;
+            if (fields.has(F::id)) {
+                retval.id = Message::Id{"42-100500"};
+            }
+            if (fields.has(F::subject)) {
+                retval.subject = Message::Subject{"I love you Ozzy!"};
+            }
+            if (fields.has(F::recipients)) {
+                retval.recipients = Message::Recipients{
+                    Recipient{Recipient::Type::from, Email{"Vasya Pupkin", "vasya@yandex.ru"}},
+                    Recipient{Recipient::Type::to, Email{"Ozzy Osbourne", "ozzy@gmail.com"}},
+                };
+            }
+            if (fields.has(F::body)) {
+                retval.body = Message::Body{genRandomBody()};
+            }
+            return retval;
+        }
 	};
 };
 
@@ -1,6 +1,8 @@
 #ifndef MODEL_DATA_MESSAGE_H_
 #define MODEL_DATA_MESSAGE_H_
 
+#include <bitset>
+#include <string>
 #include <vector>
 
 #include "email.h"
@@ -27,9 +29,43 @@ struct Message {
 using Messages = std::vector<model::Message>;
 
 /**
- * To get message abstract - to do not get a full message text
+ * The Message members a query is asked for - a projection, so a backend need
+ * not load or copy the other ones. The fields follow the member declaration
+ * order, all of them are requested by default.
  */
-std::string abstract(const Message&);
+class MessageFields {
+public:
+    enum Field : std::size_t {
+        id,
+        subject,
+        recipients,
+        body,
+        count
+    };
+    using Bits = std::bitset<count>;
+
+    MessageFields() { bits.set(); }
+    explicit MessageFields(Bits bits) : bits(bits) {}
+
+    bool has(Field f) const { return bits.test(f); }
+
+private:
+    Bits bits;
+};
+
+/**
+ * To get message abstract - to do not get a full message text. The body is
+ * cut at the last space within the first abstractSize bytes.
+ */
+constexpr std::size_t abstractSize = 256;
+
+inline std::string abstract(const Message& m) {
+    if (m.body.size() <= abstractSize) {
+        return m.body;
+    }
+    const auto space = m.body.rfind(' ', abstractSize);
+    return m.body.substr(0, space == 0 || space == std::string::npos ? abstractSize : space);
+}
 
 }
 
@@ -3,6 +3,8 @@
 
 #include <boost/fusion/adapted.hpp>
 
+#include <yamail/data/reflection/protobuf_fields.h>
+
 #include <model/data/email.h>
 
 BOOST_FUSION_ADAPT_STRUCT(
@@ -11,4 +13,6 @@ BOOST_FUSION_ADAPT_STRUCT(
     address
 )
 
+YR_PROTOBUF_FIELDS(model::Email, 1, 2)
+
 #endif /* MODEL_REFLECTION_EMAIL_H_ */
@@ -2,6 +2,9 @@
 #define MODEL_REFLECTION_MESSAGE_H_
 
 #include <yamail/data/serialization/json_writer.h>
+#include <yamail/data/serialization/cbor_writer.h>
+#include <yamail/data/serialization/protobuf_writer.h>
+#include <yamail/data/deserialization/protobuf_reader.h>
 
 #include <model/data/message.h>
 #include "recipient.h"
@@ -14,8 +17,67 @@ BOOST_FUSION_ADAPT_STRUCT(
     body
 )
 
-inline yamail::data::serialization::yajl::Buffer serialize(const model::Messages& m) {
+/**
+ * The numbers of model/protobuf/model.proto.
+ */
+YR_PROTOBUF_FIELDS(model::Message, 1, 2, 4, 3)
+
+/**
+ * The projection of a field mask on the Message members, to push it down
+ * into the Mailbox queries.
+ */
+inline model::MessageFields messageFields(const yamail::data::reflection::FieldMask& mask) {
+    static_assert(boost::fusion::result_of::size<model::Message>::value == model::MessageFields::count,
+            "model::MessageFields needs a bit for every member of model::Message");
+    const auto fields = mask.fields<model::Message>();
+    if (!fields) {
+        return model::MessageFields();
+    }
+    model::MessageFields::Bits bits;
+    for (std::size_t i = 0; i != bits.size(); ++i) {
+        bits[i] = fields->test(i);
+    }
+    return model::MessageFields(bits);
+}
+
+inline yamail::data::serialization::json::Buffer serialize(const model::Messages& m) {
     return yamail::data::serialization::toJson(m, "messages");
 }
 
+/**
+ * Bodies and other strings of at least referenceThreshold bytes with nothing
+ * to escape are referenced by the rope, so m must outlive it.
+ */
+inline yamail::data::serialization::json::Rope serializeToRope(const model::Messages& m,
+        std::size_t referenceThreshold = 0) {
+    return yamail::data::serialization::toJsonRope(m, "messages", referenceThreshold);
+}
+
+inline std::string serializeToCbor(const model::Messages& m) {
+    return yamail::data::serialization::toCbor(m, "messages");
+}
+
+/**
+ * The CBOR counterpart of serializeToRope, m must outlive the rope.
+ */
+inline yamail::data::serialization::json::Rope serializeToCborRope(const model::Messages& m,
+        std::size_t referenceThreshold = 0) {
+    return yamail::data::serialization::toCborRope(m, "messages", referenceThreshold);
+}
+
+/**
+ * The yreflection.model.Messages message of model/protobuf/model.proto,
+ * every message is its repeated field 1.
+ */
+inline std::string serializeToProtobuf(const model::Messages& m) {
+    return yamail::data::serialization::toProtobuf(m, 1);
+}
+
+/**
+ * Reads the yreflection.model.Messages message straight into the model.
+ */
+inline model::Messages deserializeFromProtobuf(const std::string& data) {
+    return yamail::data::deserialization::fromProtobuf<model::Messages>(data, 1);
+}
+
 #endif /* MODEL_REFLECTION_MESSAGE_H_ */
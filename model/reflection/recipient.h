@@ -5,10 +5,13 @@
 #include <model/data/recipient.h>
 
 #include <yamail/data/reflection/reflection.h>
+#include <yamail/data/reflection/protobuf_fields.h>
 
 BOOST_FUSION_ADAPT_ADT(model::Recipient,
     (YR_GET_WITH_NAME(type), YR_SET_WITH_NAME(setType))
     (YR_GET_WITH_NAME(email), YR_SET_WITH_NAME(setEmail))
 )
 
+YR_PROTOBUF_FIELDS(model::Recipient, 1, 2)
+
 #endif /* MODEL_REFLECTION_RECIPIENT_H_ */
@@ -0,0 +1,197 @@
+#ifndef BASE64_H_
+#define BASE64_H_
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+namespace yamail { namespace data { namespace common {
+
+/**
+ * Base64 of RFC 4648 with the standard alphabet and the '=' padding. The
+ * decoder is strict: the length must be a multiple of 4, the padding may be
+ * only at the end and any other character is an error. With SSSE3 the
+ * blocks of 12 bytes are encoded and the blocks of 16 characters are
+ * validated and decoded by the pshufb lookups, the tail goes through the
+ * scalar tables.
+ */
+namespace base64 {
+
+inline std::size_t encodedSize(std::size_t n) {
+    return (n + 2) / 3 * 4;
+}
+
+/**
+ * Size of the decoded data, the input is not validated.
+ */
+inline std::size_t decodedSize(const char* s, std::size_t n) {
+    if (n < 4) {
+        return 0;
+    }
+    return n / 4 * 3 - (s[n - 1] == '=') - (s[n - 2] == '=');
+}
+
+inline const char* alphabet() {
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    return table;
+}
+
+enum : unsigned char { invalid = 0xff };
+
+inline const std::array<unsigned char, 256>& values() {
+    static const std::array<unsigned char, 256> table = [] {
+        std::array<unsigned char, 256> retval;
+        retval.fill(invalid);
+        for (unsigned char i = 0; i < 64; ++i) {
+            retval[static_cast<unsigned char>(alphabet()[i])] = i;
+        }
+        return retval;
+    }();
+    return table;
+}
+
+inline char* encodeScalar(const unsigned char* in, std::size_t n, char* out) {
+    const char* const a = alphabet();
+    for (; n >= 3; n -= 3, in += 3) {
+        const unsigned v = (unsigned(in[0]) << 16) | (unsigned(in[1]) << 8) | in[2];
+        *out++ = a[v >> 18];
+        *out++ = a[(v >> 12) & 0x3f];
+        *out++ = a[(v >> 6) & 0x3f];
+        *out++ = a[v & 0x3f];
+    }
+    if (n) {
+        const unsigned v = (unsigned(in[0]) << 16) | (n == 2 ? unsigned(in[1]) << 8 : 0);
+        *out++ = a[v >> 18];
+        *out++ = a[(v >> 12) & 0x3f];
+        *out++ = n == 2 ? a[(v >> 6) & 0x3f] : '=';
+        *out++ = '=';
+    }
+    return out;
+}
+
+inline unsigned char* decodeScalar(const char* in, std::size_t n, unsigned char* out) {
+    if (n % 4) {
+        return nullptr;
+    }
+    const auto& v = values();
+    for (; n; n -= 4, in += 4) {
+        const unsigned char a = v[static_cast<unsigned char>(in[0])];
+        const unsigned char b = v[static_cast<unsigned char>(in[1])];
+        if (a == invalid || b == invalid) {
+            return nullptr;
+        }
+        *out++ = static_cast<unsigned char>((a << 2) | (b >> 4));
+        if (n == 4 && in[3] == '=') {
+            if (in[2] == '=') {
+                return out;
+            }
+            const unsigned char c = v[static_cast<unsigned char>(in[2])];
+            if (c == invalid) {
+                return nullptr;
+            }
+            *out++ = static_cast<unsigned char>((b << 4) | (c >> 2));
+            return out;
+        }
+        const unsigned char c = v[static_cast<unsigned char>(in[2])];
+        const unsigned char d = v[static_cast<unsigned char>(in[3])];
+        if (c == invalid || d == invalid) {
+            return nullptr;
+        }
+        *out++ = static_cast<unsigned char>((b << 4) | (c >> 2));
+        *out++ = static_cast<unsigned char>((c << 6) | d);
+    }
+    return out;
+}
+
+#if defined(__SSSE3__)
+
+inline char* encode(const unsigned char* in, std::size_t n, char* out) {
+    const __m128i spread = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m128i shifts = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    for (; n >= 16; n -= 12, in += 12, out += 16) {
+        const __m128i v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in)), spread);
+        const __m128i hi = _mm_mulhi_epu16(_mm_and_si128(v, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+        const __m128i lo = _mm_mullo_epi16(_mm_and_si128(v, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+        const __m128i indices = _mm_or_si128(hi, lo);
+        __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+        const __m128i chars = _mm_add_epi8(_mm_shuffle_epi8(shifts, range), indices);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), chars);
+    }
+    return encodeScalar(in, n, out);
+}
+
+inline unsigned char* decode(const char* in, std::size_t n, unsigned char* out) {
+    if (n % 4) {
+        return nullptr;
+    }
+    const __m128i lowLut = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+            0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m128i highLut = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i rollLut = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    // the last quad may have the padding, it is left to the scalar code
+    for (; n >= 20; n -= 16, in += 16, out += 12) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        const __m128i high = _mm_and_si128(_mm_srli_epi32(v, 4), nibble);
+        const __m128i low = _mm_and_si128(v, nibble);
+        const __m128i bad = _mm_and_si128(_mm_shuffle_epi8(lowLut, low), _mm_shuffle_epi8(highLut, high));
+        if (_mm_movemask_epi8(_mm_cmpgt_epi8(bad, _mm_setzero_si128()))) {
+            return nullptr;
+        }
+        const __m128i roll = _mm_shuffle_epi8(rollLut, _mm_add_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('/')), high));
+        const __m128i sextets = _mm_add_epi8(v, roll);
+        const __m128i pairs = _mm_maddubs_epi16(sextets, _mm_set1_epi32(0x01400140));
+        const __m128i words = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+        const __m128i bytes = _mm_shuffle_epi8(words,
+                _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out), bytes);
+        const int tail = _mm_cvtsi128_si32(_mm_srli_si128(bytes, 8));
+        std::memcpy(out + 8, &tail, 4);
+    }
+    return decodeScalar(in, n, out);
+}
+
+#else
+
+inline char* encode(const unsigned char* in, std::size_t n, char* out) {
+    return encodeScalar(in, n, out);
+}
+
+inline unsigned char* decode(const char* in, std::size_t n, unsigned char* out) {
+    return decodeScalar(in, n, out);
+}
+
+#endif
+
+inline std::string encode(const unsigned char* in, std::size_t n) {
+    std::string retval(encodedSize(n), '\0');
+    encode(in, n, &retval[0]);
+    return retval;
+}
+
+/**
+ * Decodes into the byte container (std::vector<std::uint8_t>,
+ * std::vector<char>, std::string), returns false for an invalid input.
+ */
+template <typename Container>
+inline bool decode(const char* in, std::size_t n, Container& out) {
+    if (n % 4) {
+        return false;
+    }
+    out.resize(decodedSize(in, n));
+    return n == 0 || decode(in, n, reinterpret_cast<unsigned char*>(&out[0])) != nullptr;
+}
+
+} // namespace base64
+
+}}} // namespace yamail::data::common
+
+#endif /* BASE64_H_ */
@@ -0,0 +1,69 @@
+#ifndef CBOR_H_
+#define CBOR_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace yamail { namespace data { namespace common {
+
+/**
+ * The constants of CBOR (RFC 8949) shared by cbor::Writer and cbor::Reader.
+ * An item starts with the head: the major type in the top 3 bits and the
+ * additional information in the low 5 bits - the value itself below 24 or
+ * the size of the big-endian argument that follows.
+ */
+namespace cbor {
+
+enum Major : std::uint8_t {
+    unsignedInteger = 0,
+    negativeInteger = 1,
+    byteString = 2,
+    textString = 3,
+    array = 4,
+    map = 5,
+    tag = 6,
+    simple = 7
+};
+
+enum : std::uint8_t {
+    oneByteArgument = 24,
+    twoBytesArgument = 25,
+    fourBytesArgument = 26,
+    eightBytesArgument = 27,
+    indefiniteLength = 31
+};
+
+enum : std::uint8_t {
+    falseByte = 0xf4,
+    trueByte = 0xf5,
+    nullByte = 0xf6,
+    undefinedByte = 0xf7,
+    halfByte = 0xf9,
+    floatByte = 0xfa,
+    doubleByte = 0xfb,
+    breakByte = 0xff
+};
+
+inline char initialByte(Major major, std::uint8_t info) {
+    return static_cast<char>((major << 5) | info);
+}
+
+inline void storeBigEndian(char* out, std::uint64_t v, std::size_t size) {
+    for (std::size_t i = size; i != 0; --i, v >>= 8) {
+        out[i - 1] = static_cast<char>(v & 0xff);
+    }
+}
+
+inline std::uint64_t loadBigEndian(const char* in, std::size_t size) {
+    std::uint64_t retval = 0;
+    for (std::size_t i = 0; i != size; ++i) {
+        retval = (retval << 8) | static_cast<unsigned char>(in[i]);
+    }
+    return retval;
+}
+
+} // namespace cbor
+
+}}} // namespace yamail::data::common
+
+#endif /* CBOR_H_ */
@@ -1,11 +1,10 @@
 #ifndef JSON_TO_PTREE_H_
 #define JSON_TO_PTREE_H_
 
-#include <stack>
+#include <string>
+#include <vector>
 
 #include <boost/property_tree/ptree.hpp>
-#include <boost/lexical_cast.hpp>
-#include <boost/shared_ptr.hpp>
 
 #include <yajl/yajl_parse.h>
 
@@ -21,89 +20,83 @@ namespace json2ptree {
 
 using boost::property_tree::ptree;
 
+/**
+ * Builds the tree in place - every node is appended to its parent right when
+ * it starts and the frames refer to the nodes being filled, so no subtree is
+ * copied on a container close.
+ */
 class Parser {
 public:
-    Parser()
-        : result_(new ptree)
-    {}
-
     void parse(const std::string& str);
 
     const ptree& tree() const {
-        return *result_;
+        return result_;
+    }
+
+    ptree& tree() {
+        return result_;
     }
 
     int onNull() {
-        ptree child;
+        return onString("", 0);
+    }
+
+    int onString(const char* val, std::size_t len) {
         if( frames_.empty() ) {
             return 0;
         }
-        frames_.top().addEntity( child );
+        frames_.back().addEntity().data().assign(val, len);
         return 1;
     }
 
     int onString(const std::string& val) {
-        ptree child(val);
-        if( frames_.empty() ) {
-            return 0;
-        }
-        frames_.top().addEntity( child );
-        return 1;
+        return onString(val.data(), val.size());
     }
 
     int onStartMap() {
-        Frame frame = {PtreePtr(new ptree), "", true};
-        frames_.push(frame);
-        return 1;
+        return startContainer(true);
     }
 
-    int onMapKey(const std::string& key) {
+    int onMapKey(const char* key, std::size_t len) {
         if( frames_.empty() ) {
             return 0;
         }
-        frames_.top().key = key;
+        frames_.back().key.assign(key, len);
         return 1;
     }
 
     int onStartArray() {
-        Frame frame = {PtreePtr(new ptree), "", false};
-        frames_.push(frame);
-        return 1;
+        return startContainer(false);
     }
 
     int onEndContainer() {
         if( frames_.empty() ) {
             return 0;
         }
-        const Frame oldFrame = frames_.top();
-        frames_.pop();
-        if (!frames_.empty()) {
-            frames_.top().addEntity(*oldFrame.tree);
-        } else {
-            result_ = oldFrame.tree;
-        }
+        frames_.pop_back();
         return 1;
     }
 
 private:
-    typedef boost::shared_ptr<ptree> PtreePtr;
     struct Frame {
-        ~Frame() {}
-
-        void addEntity( const ptree& entity) {
-            if (isInMapContext) {
-                tree->push_back(std::make_pair(key, entity));
-            } else {
-                tree->push_back(std::make_pair("", entity));
-            }
+        ptree& addEntity() {
+            const auto i = tree->push_back(ptree::value_type(
+                    isInMapContext ? key : std::string(), ptree()));
+            return i->second;
         }
-        PtreePtr tree;
+        ptree* tree;
         std::string key;
         bool isInMapContext;
     };
 
-    std::stack<Frame> frames_;
-    PtreePtr result_;
+    int startContainer(bool isMap) {
+        ptree& tree = frames_.empty() ? result_ : frames_.back().addEntity();
+        frames_.push_back(Frame{&tree, std::string(), isMap});
+        return 1;
+    }
+
+    std::vector<Frame> frames_;
+    ptree result_;
 };
 
 inline int onNull(void* ctx) {
@@ -111,33 +104,21 @@ inline int onNull(void* ctx) {
 }
 
 inline int onBoolean(void *ctx, int booleanVal) {
-    return static_cast<Parser*>(ctx)->onString(
-            boost::lexical_cast<std::string>(booleanVal)
-    );
-}
-
-inline int onInteger(void *ctx, long long integerVal) {
-    return static_cast<Parser*>(ctx)->onString(
-            boost::lexical_cast<std::string>(integerVal)
-            );
-}
-
-inline int onDouble(void *ctx, double doubleVal) {
-    return static_cast<Parser*>(ctx)->onString(
-            boost::lexical_cast<std::string>(doubleVal)
-    );
+    return static_cast<Parser*>(ctx)->onString(booleanVal ? "1" : "0", 1);
 }
 
 inline int onString(void * ctx, const unsigned char* stringVal, size_t stringLen) {
     return static_cast<Parser*>(ctx)->onString(
-            std::string(reinterpret_cast<const char*>(stringVal), stringLen)
+            reinterpret_cast<const char*>(stringVal), stringLen
     );
 }
 
+/**
+ * Numbers are stored as their raw JSON text - no conversion to a binary value
+ * and back, the readers parse it straight to the target type.
+ */
 inline int onNumber(void * ctx, const char* numberVal, size_t numberLen) {
-    return static_cast<Parser*>(ctx)->onString(
-            std::string(numberVal, numberLen)
-    );
+    return static_cast<Parser*>(ctx)->onString(numberVal, numberLen);
 }
 
 inline int onStartMap(void* ctx) {
@@ -146,7 +127,7 @@ inline int onStartMap(void* ctx) {
 
 inline int onMapKey(void* ctx, const unsigned char* stringVal, size_t stringLen) {
     return static_cast<Parser*>(ctx)->onMapKey(
-            std::string(reinterpret_cast<const char*>(stringVal), stringLen)
+            reinterpret_cast<const char*>(stringVal), stringLen
     );
 }
 
@@ -162,8 +143,8 @@ inline void Parser::parse(const std::string& str) {
     yajl_callbacks callbacks = {
         json2ptree::onNull,
         json2ptree::onBoolean,
-        json2ptree::onInteger,
-        json2ptree::onDouble,
+        nullptr,
+        nullptr,
         json2ptree::onNumber,
         json2ptree::onString,
         json2ptree::onStartMap,
@@ -199,7 +180,9 @@ inline void Parser::parse(const std::string& str) {
 inline boost::property_tree::ptree jsonToPtree(const std::string& json) {
     json2ptree::Parser parser;
     parser.parse(json);
-    return parser.tree();
+    boost::property_tree::ptree retval;
+    retval.swap(parser.tree());
+    return retval;
 }
 
 }}}
@@ -0,0 +1,434 @@
+#ifndef NUMERIC_FORMAT_H_
+#define NUMERIC_FORMAT_H_
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace yamail { namespace data { namespace common {
+
+/**
+ * Locale independent conversion of an arithmetic value to a text in the
+ * spirit of std::to_chars, the counterpart of numeric_translator.h. Nothing
+ * is allocated: the text is written into the caller's buffer of at least
+ * numeric::bufferSize bytes and the end of it is returned.
+ *
+ * Integers are written two digits at a time from a table, unsigned types
+ * (size_t included) never pass through a signed one. Floating point numbers
+ * are written with the shortest digits which read back to the same value
+ * (Grisu2 over the boundaries of the value's own type, so a float gets the
+ * digits of the float, not of the widened double; for about 0.1% of the
+ * values Grisu2 gives one digit more than the shortest), in the fixed notation
+ * for the decimal exponents in [-6, 21) and in the exponential one
+ * ("1e+21", "5e-324") otherwise. An integral floating point value has no
+ * decimal point ("14"), like the ptree stream translator writes it.
+ */
+namespace numeric {
+
+enum : std::size_t { bufferSize = 48 };
+
+/**
+ * Arithmetic types written as numbers: bool and the character types are
+ * not numbers for the writers.
+ */
+template <typename T>
+struct is_number : std::integral_constant<bool,
+        std::is_arithmetic<T>::value
+        && !std::is_same<T, bool>::value
+        && !std::is_same<T, char>::value
+        && !std::is_same<T, signed char>::value
+        && !std::is_same<T, unsigned char>::value
+        && !std::is_same<T, wchar_t>::value
+        && !std::is_same<T, char16_t>::value
+        && !std::is_same<T, char32_t>::value> {};
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value, bool>::type isFinite(T) {
+    return true;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value, bool>::type isFinite(T v) {
+    return std::isfinite(v);
+}
+
+inline const char* digitPairs() {
+    static const char table[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+    return table;
+}
+
+template <typename U>
+inline char* formatUnsigned(char* first, U v) {
+    char buf[std::numeric_limits<U>::digits10 + 1];
+    char* const last = buf + sizeof(buf);
+    char* p = last;
+    while (v >= 100) {
+        const unsigned i = static_cast<unsigned>(v % 100) * 2;
+        v /= 100;
+        p -= 2;
+        std::memcpy(p, digitPairs() + i, 2);
+    }
+    if (v >= 10) {
+        p -= 2;
+        std::memcpy(p, digitPairs() + static_cast<unsigned>(v) * 2, 2);
+    } else {
+        *--p = static_cast<char>('0' + static_cast<unsigned>(v));
+    }
+    std::memcpy(first, p, last - p);
+    return first + (last - p);
+}
+
+namespace grisu {
+
+template <typename Float>
+struct FloatTraits;
+
+template <>
+struct FloatTraits<double> {
+    using Bits = std::uint64_t;
+    enum { significandSize = 52, exponentSize = 11, exponentBias = 0x3FF + significandSize };
+};
+
+template <>
+struct FloatTraits<float> {
+    using Bits = std::uint32_t;
+    enum { significandSize = 23, exponentSize = 8, exponentBias = 0x7F + significandSize };
+};
+
+/**
+ * Floating point number f * 2^e with the 64-bit significand.
+ */
+struct DiyFp {
+    DiyFp() = default;
+    DiyFp(std::uint64_t f, int e) : f(f), e(e) {}
+
+    DiyFp operator-(const DiyFp& rhs) const {
+        return DiyFp(f - rhs.f, e);
+    }
+
+    /**
+     * The upper half of the 128-bit product, rounded.
+     */
+    DiyFp operator*(const DiyFp& rhs) const {
+        const std::uint64_t m32 = 0xFFFFFFFFu;
+        const std::uint64_t a = f >> 32, b = f & m32, c = rhs.f >> 32, d = rhs.f & m32;
+        const std::uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+        std::uint64_t tmp = (bd >> 32) + (ad & m32) + (bc & m32);
+        tmp += 1u << 31;
+        return DiyFp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), e + rhs.e + 64);
+    }
+
+    DiyFp normalize() const {
+        DiyFp retval = *this;
+        while (!(retval.f & (std::uint64_t(1) << 63))) {
+            retval.f <<= 1;
+            --retval.e;
+        }
+        return retval;
+    }
+
+    std::uint64_t f = 0;
+    int e = 0;
+};
+
+template <typename Float>
+inline DiyFp decompose(Float v) {
+    using Traits = FloatTraits<Float>;
+    typename Traits::Bits bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    const std::uint64_t hidden = std::uint64_t(1) << Traits::significandSize;
+    const std::uint64_t significand = bits & (hidden - 1);
+    const int exponent = static_cast<int>((bits >> Traits::significandSize) & ((1u << Traits::exponentSize) - 1));
+    return exponent ? DiyFp(significand + hidden, exponent - Traits::exponentBias)
+                    : DiyFp(significand, 1 - Traits::exponentBias);
+}
+
+/**
+ * The halfway points to the neighbours of v in the Float type, with the
+ * same exponent and the upper one normalized.
+ */
+template <typename Float>
+inline void boundaries(const DiyFp& v, DiyFp& minus, DiyFp& plus) {
+    const int significandSize = FloatTraits<Float>::significandSize;
+    const std::uint64_t hidden = std::uint64_t(1) << significandSize;
+    plus = DiyFp((v.f << 1) + 1, v.e - 1);
+    while (!(plus.f & (hidden << 1))) {
+        plus.f <<= 1;
+        --plus.e;
+    }
+    plus.f <<= 64 - significandSize - 2;
+    plus.e -= 64 - significandSize - 2;
+    minus = v.f == hidden ? DiyFp((v.f << 2) - 1, v.e - 2) : DiyFp((v.f << 1) - 1, v.e - 1);
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+}
+
+/**
+ * Normalized 10^k for k = -348, -340, ..., 340.
+ */
+inline DiyFp cachedPower(unsigned index) {
+    static const std::uint64_t significands[] = {
+        0xfa8fd5a0081c0288ull, 0xbaaee17fa23ebf76ull, 0x8b16fb203055ac76ull,
+        0xcf42894a5dce35eaull, 0x9a6bb0aa55653b2dull, 0xe61acf033d1a45dfull,
+        0xab70fe17c79ac6caull, 0xff77b1fcbebcdc4full, 0xbe5691ef416bd60cull,
+        0x8dd01fad907ffc3cull, 0xd3515c2831559a83ull, 0x9d71ac8fada6c9b5ull,
+        0xea9c227723ee8bcbull, 0xaecc49914078536dull, 0x823c12795db6ce57ull,
+        0xc21094364dfb5637ull, 0x9096ea6f3848984full, 0xd77485cb25823ac7ull,
+        0xa086cfcd97bf97f4ull, 0xef340a98172aace5ull, 0xb23867fb2a35b28eull,
+        0x84c8d4dfd2c63f3bull, 0xc5dd44271ad3cdbaull, 0x936b9fcebb25c996ull,
+        0xdbac6c247d62a584ull, 0xa3ab66580d5fdaf6ull, 0xf3e2f893dec3f126ull,
+        0xb5b5ada8aaff80b8ull, 0x87625f056c7c4a8bull, 0xc9bcff6034c13053ull,
+        0x964e858c91ba2655ull, 0xdff9772470297ebdull, 0xa6dfbd9fb8e5b88full,
+        0xf8a95fcf88747d94ull, 0xb94470938fa89bcfull, 0x8a08f0f8bf0f156bull,
+        0xcdb02555653131b6ull, 0x993fe2c6d07b7facull, 0xe45c10c42a2b3b06ull,
+        0xaa242499697392d3ull, 0xfd87b5f28300ca0eull, 0xbce5086492111aebull,
+        0x8cbccc096f5088ccull, 0xd1b71758e219652cull, 0x9c40000000000000ull,
+        0xe8d4a51000000000ull, 0xad78ebc5ac620000ull, 0x813f3978f8940984ull,
+        0xc097ce7bc90715b3ull, 0x8f7e32ce7bea5c70ull, 0xd5d238a4abe98068ull,
+        0x9f4f2726179a2245ull, 0xed63a231d4c4fb27ull, 0xb0de65388cc8ada8ull,
+        0x83c7088e1aab65dbull, 0xc45d1df942711d9aull, 0x924d692ca61be758ull,
+        0xda01ee641a708deaull, 0xa26da3999aef774aull, 0xf209787bb47d6b85ull,
+        0xb454e4a179dd1877ull, 0x865b86925b9bc5c2ull, 0xc83553c5c8965d3dull,
+        0x952ab45cfa97a0b3ull, 0xde469fbd99a05fe3ull, 0xa59bc234db398c25ull,
+        0xf6c69a72a3989f5cull, 0xb7dcbf5354e9beceull, 0x88fcf317f22241e2ull,
+        0xcc20ce9bd35c78a5ull, 0x98165af37b2153dfull, 0xe2a0b5dc971f303aull,
+        0xa8d9d1535ce3b396ull, 0xfb9b7cd9a4a7443cull, 0xbb764c4ca7a44410ull,
+        0x8bab8eefb6409c1aull, 0xd01fef10a657842cull, 0x9b10a4e5e9913129ull,
+        0xe7109bfba19c0c9dull, 0xac2820d9623bf429ull, 0x80444b5e7aa7cf85ull,
+        0xbf21e44003acdd2dull, 0x8e679c2f5e44ff8full, 0xd433179d9c8cb841ull,
+        0x9e19db92b4e31ba9ull, 0xeb96bf6ebadf77d9ull, 0xaf87023b9bf0ee6bull,
+    };
+    static const short exponents[] = {
+        -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+        -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+        -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+        -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+        56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+        375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+        694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+        1013, 1039, 1066,
+    };
+    return DiyFp(significands[index], exponents[index]);
+}
+
+/**
+ * The cached power c = 10^-k such that the binary exponent of e * c is in
+ * [-60, -32], k is returned by the decimalExponent.
+ */
+inline DiyFp cachedPowerFor(int e, int& decimalExponent) {
+    const double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int k = static_cast<int>(dk);
+    if (dk - k > 0.0) {
+        ++k;
+    }
+    const unsigned index = static_cast<unsigned>((k >> 3) + 1);
+    decimalExponent = -(-348 + static_cast<int>(index << 3));
+    return cachedPower(index);
+}
+
+inline int countDigits(std::uint32_t n) {
+    int retval = 1;
+    for (; n >= 10; n /= 10) {
+        ++retval;
+    }
+    return retval;
+}
+
+inline void round(char* digits, int length, std::uint64_t delta, std::uint64_t rest,
+                  std::uint64_t tenKappa, std::uint64_t distance) {
+    while (rest < distance && delta - rest >= tenKappa
+            && (rest + tenKappa < distance || distance - rest > rest + tenKappa - distance)) {
+        --digits[length - 1];
+        rest += tenKappa;
+    }
+}
+
+inline void generateDigits(const DiyFp& w, const DiyFp& upper, std::uint64_t delta,
+                           char* digits, int& length, int& decimalExponent) {
+    static const std::uint64_t pow10[] = {
+        1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+        1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+        100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+        1000000000000000000ull, 10000000000000000000ull
+    };
+    const DiyFp one(std::uint64_t(1) << -upper.e, upper.e);
+    const std::uint64_t distance = (upper - w).f;
+    std::uint32_t p1 = static_cast<std::uint32_t>(upper.f >> -one.e);
+    std::uint64_t p2 = upper.f & (one.f - 1);
+    int kappa = countDigits(p1);
+    length = 0;
+
+    while (kappa > 0) {
+        const std::uint32_t d = p1 / static_cast<std::uint32_t>(pow10[kappa - 1]);
+        p1 %= static_cast<std::uint32_t>(pow10[kappa - 1]);
+        if (d || length) {
+            digits[length++] = static_cast<char>('0' + d);
+        }
+        --kappa;
+        const std::uint64_t rest = (static_cast<std::uint64_t>(p1) << -one.e) + p2;
+        if (rest <= delta) {
+            decimalExponent += kappa;
+            round(digits, length, delta, rest, pow10[kappa] << -one.e, distance);
+            return;
+        }
+    }
+
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+        const char d = static_cast<char>(p2 >> -one.e);
+        if (d || length) {
+            digits[length++] = static_cast<char>('0' + d);
+        }
+        p2 &= one.f - 1;
+        --kappa;
+        if (p2 < delta) {
+            decimalExponent += kappa;
+            const int index = -kappa;
+            round(digits, length, delta, p2, one.f, distance * (index < 20 ? pow10[index] : 0));
+            return;
+        }
+    }
+}
+
+/**
+ * The shortest digits of the positive finite v: v = digits * 10^decimalExponent.
+ */
+template <typename Float>
+inline void shortest(Float v, char* digits, int& length, int& decimalExponent) {
+    const DiyFp value = decompose(v);
+    DiyFp minus, plus;
+    boundaries<Float>(value, minus, plus);
+    const DiyFp c = cachedPowerFor(plus.e, decimalExponent);
+    const DiyFp w = value.normalize() * c;
+    DiyFp upper = plus * c;
+    DiyFp lower = minus * c;
+    ++lower.f;
+    --upper.f;
+    generateDigits(w, upper, upper.f - lower.f, digits, length, decimalExponent);
+}
+
+inline char* writeExponent(char* first, int exponent) {
+    if (exponent < 0) {
+        *first++ = '-';
+        exponent = -exponent;
+    } else {
+        *first++ = '+';
+    }
+    if (exponent >= 100) {
+        *first++ = static_cast<char>('0' + exponent / 100);
+        exponent %= 100;
+    }
+    std::memcpy(first, digitPairs() + exponent * 2, 2);
+    return first + 2;
+}
+
+/**
+ * Places the decimal point into digits * 10^decimalExponent.
+ */
+inline char* layout(char* first, const char* digits, int length, int decimalExponent) {
+    const int point = length + decimalExponent;
+    if (decimalExponent >= 0 && point <= 21) {
+        std::memcpy(first, digits, length);
+        std::memset(first + length, '0', decimalExponent);
+        return first + point;
+    }
+    if (point > 0 && point <= 21) {
+        std::memcpy(first, digits, point);
+        first[point] = '.';
+        std::memcpy(first + point + 1, digits + point, length - point);
+        return first + length + 1;
+    }
+    if (point > -6 && point <= 0) {
+        first[0] = '0';
+        first[1] = '.';
+        std::memset(first + 2, '0', -point);
+        std::memcpy(first + 2 - point, digits, length);
+        return first + 2 - point + length;
+    }
+    *first++ = digits[0];
+    if (length > 1) {
+        *first++ = '.';
+        std::memcpy(first, digits + 1, length - 1);
+        first += length - 1;
+    }
+    *first++ = 'e';
+    return writeExponent(first, point - 1);
+}
+
+} // namespace grisu
+
+template <typename Float>
+inline char* formatFloat(char* first, Float v) {
+    if (std::signbit(v)) {
+        *first++ = '-';
+        v = -v;
+    }
+    if (v == 0) {
+        *first = '0';
+        return first + 1;
+    }
+    if (std::isnan(v)) {
+        std::memcpy(first, "nan", 3);
+        return first + 3;
+    }
+    if (std::isinf(v)) {
+        std::memcpy(first, "inf", 3);
+        return first + 3;
+    }
+    char digits[20];
+    int length = 0, decimalExponent = 0;
+    grisu::shortest(v, digits, length, decimalExponent);
+    return grisu::layout(first, digits, length, decimalExponent);
+}
+
+} // namespace numeric
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value, char*>::type
+formatNumber(char* first, T v) {
+    return numeric::formatUnsigned(first, v);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, char*>::type
+formatNumber(char* first, T v) {
+    using U = typename std::make_unsigned<T>::type;
+    if (v < 0) {
+        *first++ = '-';
+        return numeric::formatUnsigned(first, static_cast<U>(U(0) - static_cast<U>(v)));
+    }
+    return numeric::formatUnsigned(first, static_cast<U>(v));
+}
+
+inline char* formatNumber(char* first, float v) {
+    return numeric::formatFloat(first, v);
+}
+
+inline char* formatNumber(char* first, double v) {
+    return numeric::formatFloat(first, v);
+}
+
+/**
+ * There is no wider shortest form, long double is written as the nearest
+ * double.
+ */
+inline char* formatNumber(char* first, long double v) {
+    return numeric::formatFloat(first, static_cast<double>(v));
+}
+
+}}} // namespace yamail::data::common
+
+#endif /* NUMERIC_FORMAT_H_ */
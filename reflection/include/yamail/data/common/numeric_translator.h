@@ -0,0 +1,262 @@
+#ifndef NUMERIC_TRANSLATOR_H_
+#define NUMERIC_TRANSLATOR_H_
+
+#include <limits>
+#include <locale>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+#include <boost/optional.hpp>
+
+namespace yamail { namespace data { namespace common {
+
+/**
+ * Locale independent conversion of a text to an arithmetic value in the
+ * spirit of std::from_chars. Integers are parsed by hand with the overflow
+ * check, floating point numbers take the exact fast path (mantissa and power
+ * of ten are both exactly representable) and fall back to the classic
+ * locale stream only for the rest. Accepts the same input as the ptree
+ * stream translator: surrounding whitespace, "0"/"1"/"true"/"false" for
+ * bool and a single character for char.
+ */
+namespace numeric {
+
+inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+inline void trim(const char*& first, const char*& last) {
+    while (first != last && isSpace(*first)) {
+        ++first;
+    }
+    while (first != last && isSpace(*(last - 1))) {
+        --last;
+    }
+}
+
+inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+inline bool equal(const char* first, const char* last, const char* literal) {
+    for (; first != last && *literal; ++first, ++literal) {
+        if (*first != *literal) {
+            return false;
+        }
+    }
+    return first == last && !*literal;
+}
+
+template <typename T>
+inline bool parseStream(const char* first, const char* last, T& v) {
+    std::istringstream s(std::string(first, last));
+    s.imbue(std::locale::classic());
+    T res;
+    s >> res;
+    if (s.fail() || !(s >> std::ws).eof()) {
+        return false;
+    }
+    v = res;
+    return true;
+}
+
+/**
+ * Reads the decimal digits into an unsigned long long, fails on overflow.
+ */
+inline bool parseDigits(const char* first, const char* last, unsigned long long& v) {
+    using Limits = std::numeric_limits<unsigned long long>;
+    if (first == last) {
+        return false;
+    }
+    unsigned long long res = 0;
+    for (; first != last; ++first) {
+        if (!isDigit(*first)) {
+            return false;
+        }
+        const unsigned digit = *first - '0';
+        if (res > (Limits::max() - digit) / 10) {
+            return false;
+        }
+        res = res * 10 + digit;
+    }
+    v = res;
+    return true;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, bool>::type
+parseTrimmed(const char* first, const char* last, T& v) {
+    const bool negative = first != last && *first == '-';
+    if (first != last && (*first == '-' || *first == '+')) {
+        ++first;
+    }
+    unsigned long long abs = 0;
+    if (!parseDigits(first, last, abs)) {
+        return false;
+    }
+    const unsigned long long max = static_cast<unsigned long long>(std::numeric_limits<T>::max());
+    if (abs > max + negative) {
+        return false;
+    }
+    v = negative ? static_cast<T>(-static_cast<long long>(abs - 1) - 1) : static_cast<T>(abs);
+    return true;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value, bool>::type
+parseTrimmed(const char* first, const char* last, T& v) {
+    if (first != last && *first == '+') {
+        ++first;
+    }
+    unsigned long long res = 0;
+    if (!parseDigits(first, last, res) || res > std::numeric_limits<T>::max()) {
+        return false;
+    }
+    v = static_cast<T>(res);
+    return true;
+}
+
+inline bool parseTrimmed(const char* first, const char* last, bool& v) {
+    if (equal(first, last, "1") || equal(first, last, "true")) {
+        v = true;
+    } else if (equal(first, last, "0") || equal(first, last, "false")) {
+        v = false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Exact powers of ten - every one of them is representable by a double.
+ */
+inline double exactPow10(unsigned e) {
+    static const double values[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    return values[e];
+}
+
+/**
+ * Limits of the exact conversion to T: the mantissa must fit the digits and
+ * 5^e of the largest power of ten as well (log(2)/log(5) ~ 0.43).
+ */
+template <typename T>
+struct ExactLimits {
+    static constexpr int digits = std::numeric_limits<T>::digits < 64
+            ? std::numeric_limits<T>::digits : 63;
+    static constexpr unsigned long long maxMantissa = 1ull << digits;
+    static constexpr int maxExponent = digits * 43 / 100 < 22 ? digits * 43 / 100 : 22;
+};
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value, bool>::type
+parseTrimmed(const char* first, const char* last, T& v) {
+    const char* const begin = first;
+    const bool negative = first != last && *first == '-';
+    if (first != last && (*first == '-' || *first == '+')) {
+        ++first;
+    }
+    unsigned long long mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool anyDigit = false;
+    for (; first != last && isDigit(*first); ++first, anyDigit = true) {
+        if (mantissa || *first != '0') {
+            mantissa = mantissa * 10 + (*first - '0');
+            ++digits;
+        }
+        if (digits > 19) {
+            return parseStream(begin, last, v);
+        }
+    }
+    if (first != last && *first == '.') {
+        for (++first; first != last && isDigit(*first); ++first, anyDigit = true) {
+            if (mantissa || *first != '0') {
+                mantissa = mantissa * 10 + (*first - '0');
+                ++digits;
+            }
+            if (digits > 19) {
+                return parseStream(begin, last, v);
+            }
+            --exponent;
+        }
+    }
+    if (!anyDigit) {
+        return parseStream(begin, last, v);
+    }
+    if (first != last && (*first == 'e' || *first == 'E')) {
+        ++first;
+        int e = 0;
+        if (!parseTrimmed(first, last, e)) {
+            return parseStream(begin, last, v);
+        }
+        exponent += e;
+        first = last;
+    }
+    if (first != last) {
+        return false;
+    }
+    using Limits = ExactLimits<T>;
+    if (mantissa > Limits::maxMantissa || exponent > Limits::maxExponent
+            || exponent < -Limits::maxExponent) {
+        return parseStream(begin, last, v);
+    }
+    T res = static_cast<T>(mantissa);
+    if (exponent < 0) {
+        res /= static_cast<T>(exactPow10(-exponent));
+    } else {
+        res *= static_cast<T>(exactPow10(exponent));
+    }
+    v = negative ? -res : res;
+    return true;
+}
+
+} // namespace numeric
+
+template <typename T>
+inline bool parseNumber(const char* first, const char* last, T& v) {
+    static_assert(std::is_arithmetic<T>::value, "parseNumber is for arithmetic types only");
+    numeric::trim(first, last);
+    return numeric::parseTrimmed(first, last, v);
+}
+
+/**
+ * A char is a single character, not a number - the same as the stream does.
+ */
+inline bool parseNumber(const char* first, const char* last, char& v) {
+    if (first == last) {
+        return false;
+    }
+    const char res = *first++;
+    numeric::trim(first, last);
+    if (first != last) {
+        return false;
+    }
+    v = res;
+    return true;
+}
+
+/**
+ * boost::property_tree translator from the node data to an arithmetic value
+ * based on parseNumber.
+ */
+template <typename T>
+struct NumericTranslator {
+    typedef std::string internal_type;
+    typedef T external_type;
+
+    boost::optional<T> get_value(const std::string& s) const {
+        T v;
+        if (!parseNumber(s.data(), s.data() + s.size(), v)) {
+            return boost::none;
+        }
+        return v;
+    }
+};
+
+}}}
+
+#endif /* NUMERIC_TRANSLATOR_H_ */
@@ -0,0 +1,50 @@
+#ifndef PROTOBUF_H_
+#define PROTOBUF_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace yamail { namespace data { namespace common {
+
+/**
+ * The constants and the varints of the protobuf wire format shared by
+ * protobuf::Writer and protobuf::Reader. A field starts with the key: the
+ * varint of the field number shifted by 3 bits with the wire type in the
+ * low bits.
+ */
+namespace protobuf {
+
+enum WireType : std::uint8_t {
+    varintType = 0,
+    fixed64Type = 1,
+    lengthDelimitedType = 2,
+    fixed32Type = 5
+};
+
+enum : std::size_t { maxVarintSize = 10 };
+
+inline std::size_t varintSize(std::uint64_t v) {
+    std::size_t retval = 1;
+    for (; v >= 0x80; v >>= 7) {
+        ++retval;
+    }
+    return retval;
+}
+
+inline char* writeVarint(char* out, std::uint64_t v) {
+    for (; v >= 0x80; v >>= 7) {
+        *out++ = static_cast<char>(v | 0x80);
+    }
+    *out++ = static_cast<char>(v);
+    return out;
+}
+
+inline std::uint64_t makeKey(std::uint32_t field, WireType type) {
+    return (std::uint64_t(field) << 3) | type;
+}
+
+} // namespace protobuf
+
+}}} // namespace yamail::data::common
+
+#endif /* PROTOBUF_H_ */
@@ -0,0 +1,46 @@
+#ifndef __BINARY_READER_H_
+#define __BINARY_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace yamail { namespace data { namespace deserialization {
+
+/**
+ * The helpers shared by the readers of the binary formats. Error is the
+ * exception type of a reader, its prefix() starts every message, e.g.
+ * "cbor::Reader error: ".
+ */
+namespace detail {
+
+template <typename Error>
+inline Error expected(const std::string& what) {
+    return Error(Error::prefix() + what + " expected");
+}
+
+template <typename Error>
+inline void require(const char* p, const char* end, std::uint64_t size) {
+    if (static_cast<std::uint64_t>(end - p) < size) {
+        throw Error(Error::prefix() + "unexpected end of data");
+    }
+}
+
+/**
+ * Sizes the sequence up front when it can be resized, fixed size sequences
+ * are left as they are.
+ */
+template <typename Sequence>
+inline auto resizeSequence(Sequence& s, std::size_t size, int) -> decltype(s.resize(size)) {
+    s.resize(size);
+}
+
+template <typename Sequence>
+inline void resizeSequence(Sequence&, std::size_t, long) {
+}
+
+} // namespace detail
+
+}}}
+
+#endif // __BINARY_READER_H_
@@ -0,0 +1,533 @@
+#ifndef __CBOR_READER_H_
+#define __CBOR_READER_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/container/small_vector.hpp>
+#include <boost/utility/string_ref.hpp>
+
+#include <yamail/data/reflection/reflection.h>
+#include <yamail/data/common/cbor.h>
+#include <yamail/data/common/numeric_format.h>
+#include <yamail/data/deserialization/binary_reader.h>
+
+namespace yamail { namespace data { namespace deserialization {
+
+using namespace yamail::data::reflection;
+
+class CborReaderError : public std::runtime_error {
+public:
+    CborReaderError(const std::string& msg) : std::runtime_error(msg) {}
+
+    static std::string prefix() { return "cbor::Reader error: "; }
+};
+
+namespace cbor {
+
+using namespace common::cbor;
+
+using Error = CborReaderError;
+using detail::expected;
+using detail::require;
+using detail::resizeSequence;
+
+struct Head {
+    Major major;
+    std::uint8_t info;
+    std::uint64_t value;
+
+    bool indefinite() const { return info == indefiniteLength; }
+};
+
+/**
+ * Reads the head of the item at p and moves p past it, the semantic tags
+ * in front of the item are skipped.
+ */
+inline Head readHead(const char*& p, const char* end) {
+    for (;;) {
+        require<Error>(p, end, 1);
+        const auto initial = static_cast<unsigned char>(*p++);
+        Head h{static_cast<Major>(initial >> 5), static_cast<std::uint8_t>(initial & 0x1f), 0};
+        if (h.info < oneByteArgument) {
+            h.value = h.info;
+        } else if (h.info <= eightBytesArgument) {
+            const std::size_t size = std::size_t(1) << (h.info - oneByteArgument);
+            require<Error>(p, end, size);
+            h.value = loadBigEndian(p, size);
+            p += size;
+        } else if (h.info != indefiniteLength || h.major < byteString || h.major == tag) {
+            throw CborReaderError("cbor::Reader error: invalid additional information");
+        }
+        if (h.major != tag) {
+            return h;
+        }
+    }
+}
+
+inline bool atBreak(const char* p, const char* end) {
+    require<Error>(p, end, 1);
+    return static_cast<unsigned char>(*p) == breakByte;
+}
+
+inline bool isNull(const char* p, const char* end) {
+    require<Error>(p, end, 1);
+    const auto initial = static_cast<unsigned char>(*p);
+    return initial == nullByte || initial == undefinedByte;
+}
+
+/**
+ * Checks the count of a definite length array or map: every item takes a
+ * byte at least, so a count beyond the data is an error rather than a huge
+ * allocation.
+ */
+inline std::uint64_t itemCount(const Head& h, const char* p, const char* end) {
+    require<Error>(p, end, h.value);
+    return h.major == map ? h.value * 2 : h.value;
+}
+
+/**
+ * Nesting limit of the skipped items, deeper input is rejected rather than
+ * overflowing the stack.
+ */
+constexpr std::size_t maxSkipDepth = 128;
+
+/**
+ * Returns the end of the item at p.
+ */
+inline const char* skip(const char* p, const char* end, std::size_t depth = 0) {
+    if (depth == maxSkipDepth) {
+        throw CborReaderError("cbor::Reader error: nesting is too deep");
+    }
+    const Head h = readHead(p, end);
+    switch (h.major) {
+    case byteString:
+    case textString:
+    case array:
+    case map:
+        if (h.indefinite()) {
+            while (!atBreak(p, end)) {
+                p = skip(p, end, depth + 1);
+            }
+            return p + 1;
+        }
+        if (h.major == byteString || h.major == textString) {
+            require<Error>(p, end, h.value);
+            return p + h.value;
+        }
+        for (std::uint64_t n = itemCount(h, p, end); n != 0; --n) {
+            p = skip(p, end, depth + 1);
+        }
+        return p;
+    case simple:
+        if (h.indefinite()) {
+            throw CborReaderError("cbor::Reader error: unexpected break");
+        }
+        return p;
+    default:
+        return p;
+    }
+}
+
+/**
+ * Reads a text or a byte string, the indefinite length one is made of its
+ * definite length chunks.
+ */
+template <typename Container>
+inline const char* readString(const char* p, const char* end, Major major, Container& out) {
+    const Head h = readHead(p, end);
+    if (h.major != major) {
+        throw expected<Error>(major == textString ? "text string" : "byte string");
+    }
+    if (!h.indefinite()) {
+        require<Error>(p, end, h.value);
+        out.assign(p, p + h.value);
+        return p + h.value;
+    }
+    out.clear();
+    while (!atBreak(p, end)) {
+        const Head chunk = readHead(p, end);
+        if (chunk.major != major || chunk.indefinite()) {
+            throw CborReaderError("cbor::Reader error: invalid string chunk");
+        }
+        require<Error>(p, end, chunk.value);
+        out.insert(out.end(), p, p + chunk.value);
+        p += chunk.value;
+    }
+    return p + 1;
+}
+
+inline double halfToDouble(std::uint64_t half) {
+    const int exponent = static_cast<int>((half >> 10) & 0x1f);
+    const double mantissa = static_cast<double>(half & 0x3ff);
+    double retval;
+    if (exponent == 0) {
+        retval = std::ldexp(mantissa, -24);
+    } else if (exponent != 31) {
+        retval = std::ldexp(mantissa + 1024, exponent - 25);
+    } else {
+        retval = mantissa == 0 ? std::numeric_limits<double>::infinity()
+                : std::numeric_limits<double>::quiet_NaN();
+    }
+    return half & 0x8000 ? -retval : retval;
+}
+
+template <typename T>
+inline typename std::enable_if<common::numeric::is_number<T>::value && std::is_integral<T>::value,
+        const char*>::type
+readValue(const char* p, const char* end, T& v) {
+    const Head h = readHead(p, end);
+    if (h.major != unsignedInteger && (h.major != negativeInteger || !std::is_signed<T>::value)) {
+        throw expected<Error>(std::is_signed<T>::value ? "integer" : "unsigned integer");
+    }
+    if (h.value > static_cast<std::uint64_t>(std::numeric_limits<T>::max())) {
+        throw CborReaderError("cbor::Reader error: integer out of range");
+    }
+    v = h.major == unsignedInteger ? static_cast<T>(h.value)
+            : static_cast<T>(-static_cast<std::int64_t>(h.value) - 1);
+    return p;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value, const char*>::type
+readValue(const char* p, const char* end, T& v) {
+    const Head h = readHead(p, end);
+    if (h.major == unsignedInteger) {
+        v = static_cast<T>(h.value);
+    } else if (h.major == negativeInteger) {
+        v = T(-1) - static_cast<T>(h.value);
+    } else if (h.major == simple && h.info == twoBytesArgument) {
+        v = static_cast<T>(halfToDouble(h.value));
+    } else if (h.major == simple && h.info == fourBytesArgument) {
+        const auto bits = static_cast<std::uint32_t>(h.value);
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        v = f;
+    } else if (h.major == simple && h.info == eightBytesArgument) {
+        double d;
+        std::memcpy(&d, &h.value, sizeof(d));
+        v = static_cast<T>(d);
+    } else {
+        throw expected<Error>("number");
+    }
+    return p;
+}
+
+inline const char* readValue(const char* p, const char* end, bool& v) {
+    const Head h = readHead(p, end);
+    if (h.major != simple || (h.info != (falseByte & 0x1f) && h.info != (trueByte & 0x1f))) {
+        throw expected<Error>("boolean");
+    }
+    v = h.info == (trueByte & 0x1f);
+    return p;
+}
+
+inline const char* readValue(const char* p, const char* end, std::string& v) {
+    return readString(p, end, textString, v);
+}
+
+template <typename T>
+inline typename std::enable_if<!common::numeric::is_number<T>::value, const char*>::type
+readValue(const char* p, const char* end, T& v) {
+    std::string text;
+    p = readValue(p, end, text);
+    v = boost::lexical_cast<T>(text);
+    return p;
+}
+
+/**
+ * Reads the items the visitor asks for. A reader is either the level of a
+ * map or of an array. The map level indexes the keys of its map in one pass;
+ * struct fields come in the declaration order and map items in the key
+ * order, so a lookup checks the entry at the cursor and right after it
+ * first. Other lookups scan the entries, or the sorted index of them in a
+ * large map. The array level reads its items one by one, the root item is
+ * the only item of the root level.
+ */
+class Reader : public Visitor {
+public:
+    Reader(const char* data, std::size_t size) : pos_(data), end_(data + size), remaining_(1) {
+    }
+
+    explicit Reader(const std::string& data) : Reader(data.data(), data.size()) {
+    }
+
+    template <typename T>
+    void apply(T& res) {
+        applyVisitor(res, *this, SequenceItemTag());
+        checkEnd();
+    }
+
+    template <typename T>
+    void apply(T& res, const std::string& rootName) {
+        auto root = onStructStart(res, SequenceItemTag());
+        applyVisitor(res, root, namedItemTag(rootName));
+        checkEnd();
+    }
+
+    template <typename Value, typename ... Args>
+    void onValue(Value& v, NamedItemTag<Args...> tag) {
+        readValue(get(name(tag)), end_, v);
+    }
+
+    template <typename Value>
+    void onValue(Value& v, SequenceItemTag) {
+        pos_ = readValue(take(), end_, v);
+    }
+
+    template <typename Container, typename ... Args>
+    bool onBlob(BasicBlob<Container>& blob, NamedItemTag<Args...> tag) {
+        readString(get(name(tag)), end_, byteString, blob.data);
+        return true;
+    }
+
+    template <typename Container>
+    bool onBlob(BasicBlob<Container>& blob, SequenceItemTag) {
+        pos_ = readString(take(), end_, byteString, blob.data);
+        return true;
+    }
+
+    template <typename Struct, typename ... Args>
+    Reader onStructStart(Struct& , NamedItemTag<Args...> tag) {
+        const char* next = nullptr;
+        return mapAt(get(name(tag)), next);
+    }
+
+    template <typename Struct>
+    Reader onStructStart(Struct& , SequenceItemTag) {
+        return mapAt(take(), pos_);
+    }
+
+    template <typename Map, typename Tag>
+    Reader onMapStart(Map& m, Tag tag) {
+        auto retval = onStructStart(m, tag);
+        m.clear();
+        for (const auto& e : retval.entries_) {
+            m.emplace_hint(m.end(), std::piecewise_construct,
+                    std::forward_as_tuple(std::string(e.key.data(), e.key.size())), std::forward_as_tuple());
+        }
+        return retval;
+    }
+
+    template <typename Sequence, typename ... Args>
+    Reader onSequenceStart(Sequence& s, NamedItemTag<Args...> tag) {
+        return arrayAt(s, get(name(tag)));
+    }
+
+    template <typename Sequence>
+    Reader onSequenceStart(Sequence& s, SequenceItemTag) {
+        const char* item = take();
+        pos_ = skip(item, end_);
+        return arrayAt(s, item);
+    }
+
+    template <typename P, typename ... Args>
+    bool onOptional(boost::optional<P>& p, NamedItemTag<Args...> tag) {
+        const char* item = find(name(tag));
+        if (!item || isNull(item, end_)) {
+            p = boost::none;
+            return false;
+        }
+        p = P();
+        return true;
+    }
+
+    template <typename P>
+    bool onOptional(boost::optional<P>& p, SequenceItemTag) {
+        if (isNull(next(), end_)) {
+            pos_ = take() + 1;
+            p = boost::none;
+            return false;
+        }
+        p = P();
+        return true;
+    }
+
+    template <typename Pointer, typename ... Args>
+    bool onSmartPointer(Pointer& p, NamedItemTag<Args...> tag) {
+        const char* item = find(name(tag));
+        if (!item || isNull(item, end_)) {
+            p.reset();
+            return false;
+        }
+        p.reset(new typename Pointer::element_type);
+        return true;
+    }
+
+    template <typename Pointer>
+    bool onSmartPointer(Pointer& p, SequenceItemTag) {
+        if (isNull(next(), end_)) {
+            pos_ = take() + 1;
+            p.reset();
+            return false;
+        }
+        p.reset(new typename Pointer::element_type);
+        return true;
+    }
+
+private:
+    struct Entry {
+        boost::string_ref key;
+        const char* value;
+    };
+
+    enum { linearLookupLimit = 16 };
+
+    explicit Reader(const char* end) : end_(end) {
+    }
+
+    const char* next() const {
+        if (indefinite_ ? atBreak(pos_, end_) : remaining_ == 0) {
+            throw CborReaderError("cbor::Reader error: sequence item out of range");
+        }
+        return pos_;
+    }
+
+    const char* take() {
+        const char* retval = next();
+        --remaining_;
+        return retval;
+    }
+
+    void checkEnd() const {
+        if (pos_ != end_) {
+            throw CborReaderError("cbor::Reader error: trailing data");
+        }
+    }
+
+    Reader mapAt(const char* p, const char*& next) const {
+        Reader retval(end_);
+        const Head h = readHead(p, end_);
+        if (h.major != map) {
+            throw expected<Error>("map");
+        }
+        const auto addEntry = [&] {
+            Entry e;
+            const Head k = readHead(p, end_);
+            if (k.major != textString || k.indefinite()) {
+                throw expected<Error>("text key");
+            }
+            require<Error>(p, end_, k.value);
+            e.key = boost::string_ref(p, k.value);
+            e.value = p + k.value;
+            p = skip(e.value, end_);
+            retval.entries_.push_back(e);
+        };
+        if (h.indefinite()) {
+            while (!atBreak(p, end_)) {
+                addEntry();
+            }
+            ++p;
+        } else {
+            const std::uint64_t count = itemCount(h, p, end_) / 2;
+            retval.entries_.reserve(count);
+            for (std::uint64_t i = 0; i != count; ++i) {
+                addEntry();
+            }
+        }
+        next = p;
+        return retval;
+    }
+
+    template <typename Sequence>
+    Reader arrayAt(Sequence& s, const char* p) const {
+        Reader retval(end_);
+        const Head h = readHead(p, end_);
+        if (h.major != array) {
+            throw expected<Error>("array");
+        }
+        retval.pos_ = p;
+        retval.indefinite_ = h.indefinite();
+        retval.remaining_ = h.indefinite() ? 0 : itemCount(h, p, end_);
+        std::size_t size = static_cast<std::size_t>(retval.remaining_);
+        if (h.indefinite()) {
+            for (size = 0; !atBreak(p, end_); ++size) {
+                p = skip(p, end_);
+            }
+        }
+        resizeSequence(s, size, 0);
+        return retval;
+    }
+
+    const char* find(boost::string_ref key) {
+        const std::size_t size = entries_.size();
+        for (std::size_t i = cursor_; i < size && i < cursor_ + 2; ++i) {
+            if (entries_[i].key == key) {
+                cursor_ = i;
+                return entries_[i].value;
+            }
+        }
+        if (size <= linearLookupLimit) {
+            for (std::size_t i = 0; i != size; ++i) {
+                if (entries_[i].key == key) {
+                    cursor_ = i;
+                    return entries_[i].value;
+                }
+            }
+            return nullptr;
+        }
+        if (sorted_.empty()) {
+            sorted_.resize(size);
+            for (std::size_t i = 0; i != size; ++i) {
+                sorted_[i] = i;
+            }
+            std::sort(sorted_.begin(), sorted_.end(), [this] (std::size_t l, std::size_t r) {
+                return entries_[l].key < entries_[r].key;
+            });
+        }
+        const auto i = std::lower_bound(sorted_.begin(), sorted_.end(), key, [this] (std::size_t l, boost::string_ref k) {
+            return entries_[l].key < k;
+        });
+        if (i == sorted_.end() || entries_[*i].key != key) {
+            return nullptr;
+        }
+        cursor_ = *i;
+        return entries_[*i].value;
+    }
+
+    const char* get(boost::string_ref key) {
+        const char* retval = find(key);
+        if (!retval) {
+            throw CborReaderError("cbor::Reader error: no such field (" + key.to_string() + ")");
+        }
+        return retval;
+    }
+
+    const char* pos_ = nullptr;
+    const char* end_ = nullptr;
+    std::uint64_t remaining_ = 0;
+    bool indefinite_ = false;
+    boost::container::small_vector<Entry, linearLookupLimit> entries_;
+    std::size_t cursor_ = 0;
+    std::vector<std::size_t> sorted_;
+};
+
+} // namespace cbor
+
+template <typename T>
+inline void fromCbor(const std::string& data, T& v) {
+    cbor::Reader(data).apply(v);
+}
+
+template <typename T>
+inline T fromCbor(const std::string& data) {
+    T retval;
+    fromCbor(data, retval);
+    return retval;
+}
+
+template <typename T>
+inline T fromCbor(const std::string& data, const std::string& rootName) {
+    T retval;
+    cbor::Reader(data).apply(retval, rootName);
+    return retval;
+}
+
+}}}
+
+#endif // __CBOR_READER_H_
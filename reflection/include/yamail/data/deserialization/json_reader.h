@@ -1,23 +1,922 @@
 #ifndef __JSON_READER_H__
 #define __JSON_READER_H__
 
+#include <array>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <yamail/data/common/base64.h>
 #include <yamail/data/common/json_to_ptree.h>
 #include <yamail/data/reflection/reflection.h>
+#include <yamail/data/reflection/field_table.h>
 #include <yamail/data/deserialization/ptree_reader.h>
 
-namespace yamail { namespace data { namespace deserialization {
+#include <boost/mpl/range_c.hpp>
+
+#include <yajl/yajl_parse.h>
+
+namespace yamail { namespace data {
+
+namespace reflection {
+
+template <typename Visitor>
+struct visitPtree;
+
+} // namespace reflection
+
+namespace deserialization {
 
 using namespace yamail::data::reflection;
+
+class JsonReaderError : public std::runtime_error {
+public:
+    JsonReaderError(const std::string& msg) : std::runtime_error(msg) {}
+};
+
 namespace json {
 
-class Reader : public Visitor {};
+class Reader;
+
+/**
+ * SAX machinery of the json::Reader. yajl events are routed to a stack of
+ * frames, one per open JSON container; every frame refers to the C++ value
+ * being filled and to a stateless Handler which knows how that type reacts
+ * to the events. Handlers are selected by the same ApplyVisitor categories
+ * the other visitors use, so no intermediate tree is ever built.
+ */
+namespace detail {
+
+class Context;
+class Handler;
+
+struct Slot {
+    void* value;
+    const Handler* handler;
+};
+
+struct Frame {
+    using Buffer = std::unique_ptr<void, void(*)(void*)>;
+
+    Frame(void* value, const Handler* handler, std::size_t seen)
+    : value(value), handler(handler), seen(seen), buffer(nullptr, [](void*){}) {}
+
+    void* value;
+    const Handler* handler;
+    std::size_t index = 0;
+    std::size_t seen;
+    // Deferred assignment of a value deserialized into a buffer, used by ADT setters
+    void* owner = nullptr;
+    Buffer buffer;
+    void (*commit)(void* owner, void* buffer) = nullptr;
+};
+
+class Handler {
+public:
+    virtual void onNull(Context& c, void* v) const { onString(c, v, "", 0); }
+    virtual void onBoolean(Context& c, void* v, bool b) const { onString(c, v, b ? "1" : "0", 1); }
+    virtual void onNumber(Context& c, void* v, const char* s, std::size_t n) const { onString(c, v, s, n); }
+    virtual void onString(Context&, void*, const char*, std::size_t) const {
+        throw JsonReaderError("unexpected scalar value in json::Reader");
+    }
+    virtual void onStartMap(Context&, void*) const {
+        throw JsonReaderError("unexpected object in json::Reader");
+    }
+    virtual void onStartArray(Context&, void*) const {
+        throw JsonReaderError("unexpected array in json::Reader");
+    }
+    virtual void onMapKey(Context&, Frame&, const char*, std::size_t) const {
+        throw JsonReaderError("unexpected object key in json::Reader");
+    }
+    virtual void onItem(Context&, Frame&) const {
+        throw JsonReaderError("unexpected array item in json::Reader");
+    }
+    virtual void onEnd(Context&, Frame&) const {}
+};
+
+template <typename H>
+struct Instance {
+    static const H value;
+};
+
+template <typename H>
+const H Instance<H>::value = H();
+
+template <typename T>
+const Handler& handlerFor();
+
+class Context {
+public:
+    template <typename T>
+    void expect(T& value) {
+        expect(&value, handlerFor<T>());
+    }
+
+    void expect(void* value, const Handler& h) {
+        next_ = Slot{value, &h};
+    }
+
+    Frame& push(void* value, const Handler& h, std::size_t fields = 0) {
+        frames_.emplace_back(value, &h, seen_.size());
+        seen_.resize(seen_.size() + fields, false);
+        return frames_.back();
+    }
+
+    void pop() {
+        Frame& f = frames_.back();
+        f.handler->onEnd(*this, f);
+        if (f.commit) {
+            f.commit(f.owner, f.buffer.get());
+        }
+        seen_.resize(f.seen);
+        frames_.pop_back();
+    }
+
+    std::size_t depth() const { return frames_.size(); }
+    Frame& top() { return frames_.back(); }
+
+    std::vector<bool>::reference seen(const Frame& f, std::size_t i) { return seen_[f.seen + i]; }
+
+    void onNull() { const Slot s = take(); s.handler->onNull(*this, s.value); }
+    void onBoolean(bool b) { const Slot s = take(); s.handler->onBoolean(*this, s.value, b); }
+    void onNumber(const char* v, std::size_t n) { const Slot s = take(); s.handler->onNumber(*this, s.value, v, n); }
+    void onString(const char* v, std::size_t n) { const Slot s = take(); s.handler->onString(*this, s.value, v, n); }
+    void onStartMap() { const Slot s = take(); s.handler->onStartMap(*this, s.value); }
+    void onStartArray() { const Slot s = take(); s.handler->onStartArray(*this, s.value); }
+
+    void onMapKey(const char* k, std::size_t n) {
+        Frame& f = top();
+        f.handler->onMapKey(*this, f, k, n);
+    }
+
+    void onEndContainer() {
+        pop();
+    }
+
+private:
+    Slot take() {
+        if (!next_.handler) {
+            if (frames_.empty()) {
+                throw JsonReaderError("unexpected value after the end of json::Reader root");
+            }
+            Frame& f = top();
+            f.handler->onItem(*this, f);
+        }
+        const Slot retval = next_;
+        next_ = Slot{nullptr, nullptr};
+        return retval;
+    }
+
+    Slot next_ = Slot{nullptr, nullptr};
+    std::vector<Frame> frames_;
+    std::vector<bool> seen_;
+};
+
+/**
+ * Consumes any value without storing it - unknown keys are skipped this way.
+ */
+class SkipHandler : public Handler {
+public:
+    void onNull(Context&, void*) const override {}
+    void onBoolean(Context&, void*, bool) const override {}
+    void onNumber(Context&, void*, const char*, std::size_t) const override {}
+    void onString(Context&, void*, const char*, std::size_t) const override {}
+    void onStartMap(Context& c, void*) const override { c.push(nullptr, *this); }
+    void onStartArray(Context& c, void*) const override { c.push(nullptr, *this); }
+    void onMapKey(Context& c, Frame&, const char*, std::size_t) const override { c.expect(nullptr, *this); }
+    void onItem(Context& c, Frame&) const override { c.expect(nullptr, *this); }
+};
+
+inline const Handler& skipHandler() {
+    return Instance<SkipHandler>::value;
+}
+
+template <typename Value>
+inline typename std::enable_if<!std::is_arithmetic<Value>::value>::type
+assign(Value& v, const char* s, std::size_t n) {
+    using Translator = property_tree::Translator<Value>;
+    const boost::optional<Value> res = Translator().get_value(std::string(s, n));
+    if (!res) {
+        throw JsonReaderError("can not convert \"" + std::string(s, n) + "\" in json::Reader");
+    }
+    v = *res;
+}
+
+template <typename Value>
+inline typename std::enable_if<std::is_arithmetic<Value>::value>::type
+assign(Value& v, const char* s, std::size_t n) {
+    if (!common::parseNumber(s, s + n, v)) {
+        throw JsonReaderError("can not convert \"" + std::string(s, n) + "\" in json::Reader");
+    }
+}
+
+inline void assign(std::string& v, const char* s, std::size_t n) {
+    v.assign(s, n);
+}
+
+template <typename T>
+class ValueHandler : public Handler {
+public:
+    void onString(Context&, void* v, const char* s, std::size_t n) const override {
+        assign(*static_cast<T*>(v), s, n);
+    }
+};
+
+template <>
+class ValueHandler<bool> : public Handler {
+public:
+    void onBoolean(Context&, void* v, bool b) const override {
+        *static_cast<bool*>(v) = b;
+    }
+    void onString(Context&, void* v, const char* s, std::size_t n) const override {
+        assign(*static_cast<bool*>(v), s, n);
+    }
+};
+
+inline bool equal(const std::string& name, const char* key, std::size_t n) {
+    return name.size() == n && !std::memcmp(name.data(), key, n);
+}
+
+template <typename T>
+struct is_required : boost::mpl::not_<boost::mpl::or_<
+        is_optional<T>, is_smart_ptr<T>>> {};
+
+template <typename View>
+using MemberName = typename std::decay<
+        typename boost::fusion::result_of::value_at_c<
+        typename std::decay<View>::type, 0>::type>::type;
+
+template <typename View>
+using Member = typename std::decay<
+        typename boost::fusion::result_of::at_c<View, 1>::type>::type;
+
+template <typename Proxy>
+using AdtValue = typename members::adt_setter_buffer<Proxy>::type;
+
+/**
+ * Reads a value of an ADT setter into a default constructed buffer and moves
+ * the buffer into the setter when the value is complete.
+ */
+template <typename Proxy, typename Struct>
+class AdtSetterHandler : public Handler {
+public:
+    using Value = AdtValue<Proxy>;
+
+    void onNull(Context& c, void* v) const override {
+        scalar(c, v, [&](void* b){ handlerFor<Value>().onNull(c, b); });
+    }
+    void onBoolean(Context& c, void* v, bool x) const override {
+        scalar(c, v, [&](void* b){ handlerFor<Value>().onBoolean(c, b, x); });
+    }
+    void onNumber(Context& c, void* v, const char* s, std::size_t n) const override {
+        scalar(c, v, [&](void* b){ handlerFor<Value>().onNumber(c, b, s, n); });
+    }
+    void onString(Context& c, void* v, const char* s, std::size_t n) const override {
+        scalar(c, v, [&](void* b){ handlerFor<Value>().onString(c, b, s, n); });
+    }
+    void onStartMap(Context& c, void* v) const override {
+        container(c, v, [&](void* b){ handlerFor<Value>().onStartMap(c, b); });
+    }
+    void onStartArray(Context& c, void* v) const override {
+        container(c, v, [&](void* b){ handlerFor<Value>().onStartArray(c, b); });
+    }
+
+private:
+    static Proxy proxy(void* v) { return Proxy(*static_cast<Struct*>(v)); }
+
+    static void commit(void* v, void* buf) {
+        proxy(v) = members::moveToSetter(*static_cast<Value*>(buf));
+    }
+
+    template <typename F>
+    static void scalar(Context&, void* v, F read) {
+        Value buf{};
+        read(&buf);
+        commit(v, &buf);
+    }
+
+    template <typename F>
+    static void container(Context& c, void* v, F read) {
+        Frame::Buffer buf(new Value(), [](void* b){ delete static_cast<Value*>(b); });
+        const auto depth = c.depth();
+        read(buf.get());
+        if (c.depth() == depth) {
+            commit(v, buf.get());
+            return;
+        }
+        Frame& f = c.top();
+        f.owner = v;
+        f.buffer = std::move(buf);
+        f.commit = &AdtSetterHandler::commit;
+    }
+};
+
+template <typename T>
+class StructHandler : public Handler {
+public:
+    using Size = typename boost::fusion::result_of::size<T>::type;
+
+    void onNull(Context& c, void* v) const override {
+        onStartMap(c, v);
+        c.pop();
+    }
+
+    void onStartMap(Context& c, void* v) const override {
+        c.push(v, *this, Size::value);
+    }
+
+    void onMapKey(Context& c, Frame& f, const char* key, std::size_t n) const override {
+        const std::size_t index = members::fieldTable<T>().find(key, n);
+        if (index == members::FieldTable::npos || excluded(index)) {
+            c.expect(nullptr, skipHandler());
+            return;
+        }
+        c.seen(f, index) = true;
+        binders()[index](c, f);
+    }
+
+    void onEnd(Context& c, Frame& f) const override {
+        std::size_t index = 0;
+        auto members = members::make_vector(*static_cast<T*>(f.value));
+        boost::fusion::for_each(members, Check{c, f, index});
+    }
+
+private:
+    template <typename View>
+    static NamedItemTag<MemberName<View>> tag(const View&) { return NamedItemTag<MemberName<View>>{}; }
+
+    /**
+     * Members out of the active FieldMask are skipped like unknown keys.
+     */
+    static bool excluded(std::size_t index) {
+        const FieldMask* mask = FieldMask::current();
+        const FieldMask::Fields* fields = mask ? mask->fields<T>() : nullptr;
+        return fields && !fields->test(index);
+    }
+
+    /**
+     * Binders expect the member of the given index, they are indexed by
+     * the member index of members::fieldTable<T>().
+     */
+    using Binder = void (*)(Context&, Frame&);
+    using Binders = std::array<Binder, Size::value>;
+
+    template <int I>
+    static void bind(Context& c, Frame& f) {
+        auto members = members::make_vector(*static_cast<T*>(f.value));
+        Bind{c, f}.expect(boost::fusion::at_c<1>(boost::fusion::at_c<I>(members)));
+    }
+
+    struct FillBinders {
+        Binders& binders;
+
+        template <typename I>
+        void operator()(I) const {
+            binders[I::value] = &bind<I::value>;
+        }
+    };
+
+    static const Binders& binders() {
+        static const Binders retval = [] {
+            Binders b;
+            boost::mpl::for_each<boost::mpl::range_c<int, 0, Size::value>>(FillBinders{b});
+            return b;
+        }();
+        return retval;
+    }
+
+    struct Bind {
+        Context& c;
+        Frame& f;
+
+        template <typename Value, typename V = typename std::decay<Value>::type>
+        typename std::enable_if<!members::is_adt_setter<V>::value>::type
+        expect(Value& value) const {
+            c.expect(value);
+        }
+
+        template <typename Proxy, typename P = typename std::decay<Proxy>::type>
+        typename std::enable_if<members::is_adt_setter<P>::value>::type
+        expect(Proxy) const {
+            c.expect(f.value, Instance<AdtSetterHandler<P, T>>::value);
+        }
+    };
+
+    struct Check {
+        Context& c;
+        Frame& f;
+        std::size_t& index;
+
+        template <typename View>
+        void operator()(View view) const {
+            if (!c.seen(f, index) && required<Member<View>>() && !excluded(index)) {
+                throw JsonReaderError(std::string("field \"") + std::string(name(tag(view)))
+                        + "\" not found in json::Reader");
+            }
+            ++index;
+        }
+
+        template <typename V>
+        static typename std::enable_if<!members::is_adt_setter<V>::value, bool>::type required() {
+            return is_required<V>::value;
+        }
+
+        template <typename P>
+        static typename std::enable_if<members::is_adt_setter<P>::value, bool>::type required() {
+            return is_required<AdtValue<P>>::value;
+        }
+    };
+};
+
+template <typename T>
+class SequenceHandler : public Handler {
+public:
+    void onNull(Context&, void* v) const override {
+        static_cast<T*>(v)->clear();
+    }
+    void onStartArray(Context& c, void* v) const override {
+        static_cast<T*>(v)->clear();
+        c.push(v, *this);
+    }
+    void onItem(Context& c, Frame& f) const override {
+        T& seq = *static_cast<T*>(f.value);
+        seq.emplace_back();
+        c.expect(seq.back());
+    }
+};
+
+template <typename T, std::size_t N>
+class SequenceHandler<T[N]> : public Handler {
+public:
+    void onNull(Context&, void*) const override {}
+    void onStartArray(Context& c, void* v) const override {
+        c.push(v, *this);
+    }
+    void onItem(Context& c, Frame& f) const override {
+        if (f.index == N) {
+            throw JsonReaderError("too many items for a fixed size array in json::Reader");
+        }
+        c.expect((*static_cast<T(*)[N]>(f.value))[f.index++]);
+    }
+};
+
+template <typename T>
+class BlobHandler : public Handler {
+public:
+    void onNull(Context&, void* v) const override {
+        static_cast<T*>(v)->data.clear();
+    }
+    void onString(Context&, void* v, const char* s, std::size_t n) const override {
+        if (!common::base64::decode(s, n, static_cast<T*>(v)->data)) {
+            throw JsonReaderError("invalid base64 in json::Reader");
+        }
+    }
+};
+
+template <typename T>
+class MapHandler : public Handler {
+public:
+    void onNull(Context&, void*) const override {}
+    void onStartMap(Context& c, void* v) const override {
+        c.push(v, *this);
+    }
+    void onMapKey(Context& c, Frame& f, const char* key, std::size_t n) const override {
+        T& map = *static_cast<T*>(f.value);
+        c.expect(map[typename T::key_type(key, n)]);
+    }
+};
+
+/**
+ * Null arithmetic optional stays uninitialized, any other optional gets
+ * initialized by the value presence - the same way the ptree reader does.
+ */
+template <typename T>
+class OptionalHandler : public Handler {
+public:
+    using Value = typename T::value_type;
+    using Arithmetic = std::is_arithmetic<Value>;
+
+    void onNull(Context& c, void* v) const override {
+        if (Arithmetic::value) {
+            *static_cast<T*>(v) = boost::none;
+        } else {
+            handlerFor<Value>().onNull(c, init(v));
+        }
+    }
+    void onBoolean(Context& c, void* v, bool b) const override {
+        handlerFor<Value>().onBoolean(c, init(v), b);
+    }
+    void onNumber(Context& c, void* v, const char* s, std::size_t n) const override {
+        handlerFor<Value>().onNumber(c, init(v), s, n);
+    }
+    void onString(Context& c, void* v, const char* s, std::size_t n) const override {
+        if (Arithmetic::value && !n) {
+            *static_cast<T*>(v) = boost::none;
+        } else {
+            handlerFor<Value>().onString(c, init(v), s, n);
+        }
+    }
+    void onStartMap(Context& c, void* v) const override {
+        if (Arithmetic::value) {
+            *static_cast<T*>(v) = boost::none;
+            skipHandler().onStartMap(c, v);
+        } else {
+            handlerFor<Value>().onStartMap(c, init(v));
+        }
+    }
+    void onStartArray(Context& c, void* v) const override {
+        if (Arithmetic::value) {
+            *static_cast<T*>(v) = boost::none;
+            skipHandler().onStartArray(c, v);
+        } else {
+            handlerFor<Value>().onStartArray(c, init(v));
+        }
+    }
+
+private:
+    static Value* init(void* v) {
+        T& opt = *static_cast<T*>(v);
+        opt = Value();
+        return opt.get_ptr();
+    }
+};
+
+template <typename T>
+class SmartPtrHandler : public Handler {
+public:
+    using Value = typename T::element_type;
+
+    void onNull(Context& c, void* v) const override {
+        handlerFor<Value>().onNull(c, init(v));
+    }
+    void onBoolean(Context& c, void* v, bool b) const override {
+        handlerFor<Value>().onBoolean(c, init(v), b);
+    }
+    void onNumber(Context& c, void* v, const char* s, std::size_t n) const override {
+        handlerFor<Value>().onNumber(c, init(v), s, n);
+    }
+    void onString(Context& c, void* v, const char* s, std::size_t n) const override {
+        handlerFor<Value>().onString(c, init(v), s, n);
+    }
+    void onStartMap(Context& c, void* v) const override {
+        handlerFor<Value>().onStartMap(c, init(v));
+    }
+    void onStartArray(Context& c, void* v) const override {
+        handlerFor<Value>().onStartArray(c, init(v));
+    }
+
+private:
+    static Value* init(void* v) {
+        T& ptr = *static_cast<T*>(v);
+        ptr.reset(new Value);
+        return ptr.get();
+    }
+};
+
+/**
+ * Fills boost::property_tree::ptree members the same way common::jsonToPtree does.
+ */
+class PtreeHandler : public Handler {
+public:
+    void onString(Context&, void* v, const char* s, std::size_t n) const override {
+        static_cast<ptree*>(v)->data().assign(s, n);
+    }
+    void onStartMap(Context& c, void* v) const override {
+        c.push(v, *this);
+    }
+    void onStartArray(Context& c, void* v) const override {
+        c.push(v, *this);
+    }
+    void onMapKey(Context& c, Frame& f, const char* key, std::size_t n) const override {
+        ptree& tree = *static_cast<ptree*>(f.value);
+        c.expect(&tree.push_back(std::make_pair(std::string(key, n), ptree()))->second, *this);
+    }
+    void onItem(Context& c, Frame& f) const override {
+        ptree& tree = *static_cast<ptree*>(f.value);
+        c.expect(&tree.push_back(std::make_pair(std::string(), ptree()))->second, *this);
+    }
+};
+
+template <typename T>
+ValueHandler<T> select(const ApplyPodVisitor<T, Reader>*);
+
+template <typename T>
+StructHandler<T> select(const ApplyStructVisitor<T, Reader>*);
+
+template <typename T>
+StructHandler<T> select(const ApplyPairVisitor<T, Reader>*);
+
+template <typename T>
+SequenceHandler<T> select(const ApplySequenceVisitor<T, Reader>*);
+
+template <typename T>
+SequenceHandler<T> select(const ApplyArithmeticRangeVisitor<T, Reader>*);
+
+template <typename T>
+MapHandler<T> select(const ApplyMapVisitor<T, Reader>*);
+
+template <typename T>
+BlobHandler<T> select(const ApplyBlobVisitor<T, Reader>*);
+
+template <typename T>
+OptionalHandler<T> select(const ApplyOptionalVisitor<T, Reader>*);
+
+template <typename T>
+SmartPtrHandler<T> select(const ApplySmartPtrVisitor<T, Reader>*);
+
+template <typename T>
+PtreeHandler select(const visitPtree<Reader>*);
+
+template <typename T>
+using HandlerFor = decltype(select<T>(static_cast<const ApplyVisitor<T, Reader>*>(nullptr)));
+
+template <typename T>
+inline const Handler& handlerFor() {
+    return Instance<HandlerFor<T>>::value;
+}
+
+/**
+ * Owns the yajl handle and feeds its callbacks into the Context.
+ */
+class Parser {
+public:
+    Parser() : handle_(yajl_alloc(&callbacks(), nullptr, this), yajl_free) {
+        if (!handle_) {
+            throw JsonReaderError("yajl_alloc failed");
+        }
+    }
+
+    Parser(const Parser&) = delete;
+    Parser& operator=(const Parser&) = delete;
+
+    Context& context() { return context_; }
+
+    void parse(const char* data, std::size_t size) {
+        const auto str = reinterpret_cast<const unsigned char*>(data);
+        check(yajl_parse(handle_.get(), str, size), "yajl_parse", str, size);
+    }
+
+    void complete() {
+        check(yajl_complete_parse(handle_.get()), "yajl_complete_parse", nullptr, 0);
+    }
+
+private:
+    void check(yajl_status res, const char* what, const unsigned char* str, std::size_t size) {
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+        if (res != yajl_status_ok) {
+            unsigned char* err = yajl_get_error(handle_.get(), str != nullptr, str, size);
+            const std::string errStr(reinterpret_cast<char*>(err));
+            yajl_free_error(handle_.get(), err);
+            throw JsonReaderError(std::string(what) + " failed: " + errStr);
+        }
+    }
+
+    template <typename F>
+    static int call(void* ctx, F f) {
+        Parser& self = *static_cast<Parser*>(ctx);
+        try {
+            f(self.context_);
+            return 1;
+        } catch (...) {
+            self.error_ = std::current_exception();
+            return 0;
+        }
+    }
+
+    static int onNull(void* ctx) {
+        return call(ctx, [](Context& c){ c.onNull(); });
+    }
+    static int onBoolean(void* ctx, int v) {
+        return call(ctx, [=](Context& c){ c.onBoolean(v); });
+    }
+    static int onNumber(void* ctx, const char* v, size_t n) {
+        return call(ctx, [=](Context& c){ c.onNumber(v, n); });
+    }
+    static int onString(void* ctx, const unsigned char* v, size_t n) {
+        return call(ctx, [=](Context& c){ c.onString(reinterpret_cast<const char*>(v), n); });
+    }
+    static int onStartMap(void* ctx) {
+        return call(ctx, [](Context& c){ c.onStartMap(); });
+    }
+    static int onMapKey(void* ctx, const unsigned char* v, size_t n) {
+        return call(ctx, [=](Context& c){ c.onMapKey(reinterpret_cast<const char*>(v), n); });
+    }
+    static int onStartArray(void* ctx) {
+        return call(ctx, [](Context& c){ c.onStartArray(); });
+    }
+    static int onEndContainer(void* ctx) {
+        return call(ctx, [](Context& c){ c.onEndContainer(); });
+    }
+
+    static const yajl_callbacks& callbacks() {
+        static const yajl_callbacks retval = {
+            onNull,
+            onBoolean,
+            nullptr,
+            nullptr,
+            onNumber,
+            onString,
+            onStartMap,
+            onMapKey,
+            onEndContainer,
+            onStartArray,
+            onEndContainer
+        };
+        return retval;
+    }
+
+    std::unique_ptr<yajl_handle_t, void(*)(yajl_handle)> handle_;
+    Context context_;
+    std::exception_ptr error_;
+};
+
+} // namespace detail
+
+/**
+ * Streaming JSON reader - fills the value directly from the yajl events.
+ */
+class Reader {
+public:
+    explicit Reader(const std::string& json) : json_(json) {
+    }
+
+    template <typename T>
+    void apply(T& res) {
+        detail::Parser parser;
+        parser.context().expect(res);
+        parser.parse(json_.data(), json_.size());
+        parser.complete();
+    }
+
+private:
+    const std::string& json_;
+};
+
+namespace detail {
+
+/**
+ * Fills the current item of a StreamReader and hands it to the reader
+ * as soon as the item value is complete.
+ */
+template <typename Reader>
+class StreamItemHandler : public Handler {
+public:
+    using Value = typename Reader::value_type;
+
+    void onNull(Context& c, void* v) const override {
+        read(c, v, [&](void* i){ handlerFor<Value>().onNull(c, i); });
+    }
+    void onBoolean(Context& c, void* v, bool x) const override {
+        read(c, v, [&](void* i){ handlerFor<Value>().onBoolean(c, i, x); });
+    }
+    void onNumber(Context& c, void* v, const char* s, std::size_t n) const override {
+        read(c, v, [&](void* i){ handlerFor<Value>().onNumber(c, i, s, n); });
+    }
+    void onString(Context& c, void* v, const char* s, std::size_t n) const override {
+        read(c, v, [&](void* i){ handlerFor<Value>().onString(c, i, s, n); });
+    }
+    void onStartMap(Context& c, void* v) const override {
+        read(c, v, [&](void* i){ handlerFor<Value>().onStartMap(c, i); });
+    }
+    void onStartArray(Context& c, void* v) const override {
+        read(c, v, [&](void* i){ handlerFor<Value>().onStartArray(c, i); });
+    }
+
+private:
+    static void commit(void* v, void*) {
+        static_cast<Reader*>(v)->emit();
+    }
+
+    template <typename F>
+    static void read(Context& c, void* v, F f) {
+        const auto depth = c.depth();
+        f(static_cast<Reader*>(v)->reset());
+        if (c.depth() == depth) {
+            commit(v, nullptr);
+            return;
+        }
+        Frame& top = c.top();
+        top.owner = v;
+        top.commit = &StreamItemHandler::commit;
+    }
+};
+
+/**
+ * The array of items - every element is routed to the StreamItemHandler.
+ */
+template <typename Reader>
+class StreamArrayHandler : public Handler {
+public:
+    void onNull(Context&, void*) const override {}
+    void onStartArray(Context& c, void* v) const override {
+        c.push(v, *this);
+    }
+    void onItem(Context& c, Frame& f) const override {
+        c.expect(f.value, Instance<StreamItemHandler<Reader>>::value);
+    }
+};
+
+/**
+ * The document root - either the array itself or an object with the array
+ * under the given key; all other keys are skipped.
+ */
+template <typename Reader>
+class StreamRootHandler : public Handler {
+public:
+    void onStartMap(Context& c, void* v) const override {
+        if (static_cast<Reader*>(v)->key().empty()) {
+            Handler::onStartMap(c, v);
+        } else {
+            c.push(v, *this);
+        }
+    }
+    void onStartArray(Context& c, void* v) const override {
+        if (static_cast<Reader*>(v)->key().empty()) {
+            Instance<StreamArrayHandler<Reader>>::value.onStartArray(c, v);
+        } else {
+            Handler::onStartArray(c, v);
+        }
+    }
+    void onMapKey(Context& c, Frame& f, const char* key, std::size_t n) const override {
+        if (equal(static_cast<Reader*>(f.value)->key(), key, n)) {
+            c.expect(f.value, Instance<StreamArrayHandler<Reader>>::value);
+        } else {
+            c.expect(nullptr, skipHandler());
+        }
+    }
+};
+
+} // namespace detail
+
+/**
+ * Incremental JSON reader for documents with one huge array. The document is
+ * fed by chunks of arbitrary size, every element of the array is
+ * deserialized into T and passed to the callback right after its closing
+ * token, so only one element is held in memory at a time.
+ *
+ * The array is either the document root (empty key) or the value of the
+ * given key of the root object, e.g. "messages" for {"messages":[...]}.
+ */
+template <typename T>
+class StreamReader {
+public:
+    using value_type = T;
+    using Callback = std::function<void (T&&)>;
+
+    StreamReader(std::string key, Callback callback)
+    : key_(std::move(key)), callback_(std::move(callback)) {
+        parser_.context().expect(this, detail::Instance<detail::StreamRootHandler<StreamReader>>::value);
+    }
+
+    StreamReader(const StreamReader&) = delete;
+    StreamReader& operator=(const StreamReader&) = delete;
+
+    void feed(const char* data, std::size_t size) {
+        parser_.parse(data, size);
+    }
+
+    void feed(const std::string& chunk) {
+        feed(chunk.data(), chunk.size());
+    }
+
+    /**
+     * Must be called after the last chunk - flushes the trailing token and
+     * checks the document is complete.
+     */
+    void complete() {
+        parser_.complete();
+    }
+
+    const std::string& key() const { return key_; }
+
+private:
+    friend class detail::StreamItemHandler<StreamReader>;
+
+    T* reset() {
+        item_ = T();
+        return &item_;
+    }
+
+    void emit() {
+        callback_(std::move(item_));
+    }
+
+    std::string key_;
+    Callback callback_;
+    T item_;
+    detail::Parser parser_;
+};
 
 } // namespace json
 
 template <typename T>
 inline void fromJson(const std::string& json, T& v) {
-    auto tree = common::jsonToPtree(json);
-    fromPtree(tree, v);
+    json::Reader(json).apply(v);
 }
 
 template <typename T>
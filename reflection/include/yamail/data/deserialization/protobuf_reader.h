@@ -0,0 +1,686 @@
+#ifndef __PROTOBUF_READER_H_
+#define __PROTOBUF_READER_H_
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/container/small_vector.hpp>
+#include <boost/range/value_type.hpp>
+
+#include <yamail/data/reflection/reflection.h>
+#include <yamail/data/reflection/protobuf_fields.h>
+#include <yamail/data/common/protobuf.h>
+#include <yamail/data/deserialization/binary_reader.h>
+
+namespace yamail { namespace data { namespace deserialization {
+
+using namespace yamail::data::reflection;
+
+class ProtobufReaderError : public std::runtime_error {
+public:
+    ProtobufReaderError(const std::string& msg) : std::runtime_error(msg) {}
+
+    static std::string prefix() { return "protobuf::Reader error: "; }
+};
+
+namespace protobuf {
+
+using namespace common::protobuf;
+
+using Error = ProtobufReaderError;
+using detail::expected;
+using detail::require;
+using detail::resizeSequence;
+
+inline std::uint64_t readVarint(const char*& p, const char* end) {
+    std::uint64_t retval = 0;
+    for (unsigned shift = 0; shift < 7 * maxVarintSize; shift += 7) {
+        require<Error>(p, end, 1);
+        const auto byte = static_cast<unsigned char>(*p++);
+        retval |= std::uint64_t(byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            return retval;
+        }
+    }
+    throw ProtobufReaderError("protobuf::Reader error: varint is too long");
+}
+
+inline std::uint64_t readFixed(const char*& p, const char* end, std::size_t size) {
+    require<Error>(p, end, size);
+    std::uint64_t retval = 0;
+    for (std::size_t i = size; i != 0; --i) {
+        retval = (retval << 8) | static_cast<unsigned char>(p[i - 1]);
+    }
+    p += size;
+    return retval;
+}
+
+/**
+ * A field of a message: the value of a varint or a fixed field, or the
+ * length and the payload of a length delimited one.
+ */
+struct Field {
+    std::uint32_t number;
+    WireType type;
+    std::uint64_t value;
+    const char* data;
+};
+
+struct ByNumber {
+    bool operator()(const Field& lhs, const Field& rhs) const { return lhs.number < rhs.number; }
+    bool operator()(const Field& lhs, std::uint32_t rhs) const { return lhs.number < rhs; }
+    bool operator()(std::uint32_t lhs, const Field& rhs) const { return lhs < rhs.number; }
+};
+
+/**
+ * The field numbers a message is read with, the other fields are skipped.
+ * The numbers below 64 are looked up in a bit mask.
+ */
+class FieldSet {
+public:
+    FieldSet(const std::uint32_t* numbers, std::size_t size) {
+        for (std::size_t i = 0; i != size; ++i) {
+            add(numbers[i]);
+        }
+        std::sort(high_.begin(), high_.end());
+    }
+
+    explicit FieldSet(std::uint32_t number) {
+        add(number);
+    }
+
+    /**
+     * The fields 1..count of a tuple or of a map entry.
+     */
+    static FieldSet range(std::uint32_t count) {
+        FieldSet retval;
+        for (std::uint32_t n = 1; n <= count; ++n) {
+            retval.add(n);
+        }
+        return retval;
+    }
+
+    bool contains(std::uint32_t number) const {
+        return number < 64 ? (low_ >> number) & 1
+                : std::binary_search(high_.begin(), high_.end(), number);
+    }
+
+private:
+    FieldSet() = default;
+
+    void add(std::uint32_t number) {
+        if (number < 64) {
+            low_ |= std::uint64_t(1) << number;
+        } else {
+            high_.push_back(number);
+        }
+    }
+
+    std::uint64_t low_ = 0;
+    std::vector<std::uint32_t> high_;
+};
+
+/**
+ * The field set of an adapted type, made of its YR_PROTOBUF_FIELDS once.
+ */
+template <typename T>
+inline const FieldSet& fieldSet(T*) {
+    static const FieldSet retval(protobuf_fields<T>::numbers(), boost::fusion::result_of::size<T>::value);
+    return retval;
+}
+
+template <typename ... T>
+inline const FieldSet& fieldSet(std::tuple<T...>*) {
+    static const FieldSet retval = FieldSet::range(sizeof...(T));
+    return retval;
+}
+
+template <typename ... T>
+inline const FieldSet& fieldSet(boost::tuple<T...>*) {
+    static const FieldSet retval = FieldSet::range(boost::tuples::length<boost::tuple<T...>>::value);
+    return retval;
+}
+
+inline const FieldSet& entryFieldSet() {
+    static const FieldSet retval = FieldSet::range(2);
+    return retval;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type
+readValue(const Field& f, T& v) {
+    if (f.type == lengthDelimitedType) {
+        throw expected<Error>("integer");
+    }
+    if (std::is_signed<T>::value) {
+        const std::int64_t value = f.type == fixed32Type
+                ? static_cast<std::int32_t>(static_cast<std::uint32_t>(f.value))
+                : static_cast<std::int64_t>(f.value);
+        if (value < static_cast<std::int64_t>(std::numeric_limits<T>::min())
+                || value > static_cast<std::int64_t>(std::numeric_limits<T>::max())) {
+            throw ProtobufReaderError("protobuf::Reader error: integer out of range");
+        }
+        v = static_cast<T>(value);
+    } else {
+        if (f.value > static_cast<std::uint64_t>(std::numeric_limits<T>::max())) {
+            throw ProtobufReaderError("protobuf::Reader error: integer out of range");
+        }
+        v = static_cast<T>(f.value);
+    }
+}
+
+inline void readValue(const Field& f, bool& v) {
+    if (f.type != varintType) {
+        throw expected<Error>("boolean");
+    }
+    v = f.value != 0;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value>::type
+readValue(const Field& f, T& v) {
+    if (f.type == fixed32Type) {
+        const auto bits = static_cast<std::uint32_t>(f.value);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        v = value;
+    } else if (f.type == fixed64Type) {
+        double value;
+        std::memcpy(&value, &f.value, sizeof(value));
+        v = static_cast<T>(value);
+    } else {
+        throw expected<Error>("float or double");
+    }
+}
+
+inline void readValue(const Field& f, std::string& v) {
+    if (f.type != lengthDelimitedType) {
+        throw expected<Error>("string");
+    }
+    v.assign(f.data, static_cast<std::size_t>(f.value));
+}
+
+template <typename T>
+inline typename std::enable_if<!std::is_arithmetic<T>::value>::type
+readValue(const Field& f, T& v) {
+    std::string text;
+    readValue(f, text);
+    v = boost::lexical_cast<T>(text);
+}
+
+/**
+ * The items of a packed field.
+ */
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value, Field>::type
+packedItem(const char*& p, const char* end) {
+    return Field{0, varintType, readVarint(p, end), nullptr};
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value, Field>::type
+packedItem(const char*& p, const char* end) {
+    return sizeof(T) == 4 ? Field{0, fixed32Type, readFixed(p, end, 4), nullptr}
+            : Field{0, fixed64Type, readFixed(p, end, 8), nullptr};
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value, std::size_t>::type
+packedCount(const Field& f) {
+    return static_cast<std::size_t>(std::count_if(f.data, f.data + f.value, [] (char c) {
+        return static_cast<unsigned char>(c) < 0x80;
+    }));
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value, std::size_t>::type
+packedCount(const Field& f) {
+    return static_cast<std::size_t>(f.value / (sizeof(T) == 4 ? 4 : 8));
+}
+
+struct RootNodeTag {};
+
+/**
+ * The value is the field with the number of the enclosing message.
+ */
+struct FieldNumberTag {
+    std::uint32_t number;
+};
+
+/**
+ * Reads the wire format written by serialization::protobuf::Writer. A reader
+ * is the level of a message or of a repeated field. The message level scans
+ * its message once, skips the fields the type has no number for and keeps
+ * the others sorted by the number, so a member finds its field by the
+ * number of YR_PROTOBUF_FIELDS; the last one wins for a scalar. The repeated
+ * level reads the fields of one number in order and unpacks the packed ones.
+ * A missing field resets its member.
+ */
+class Reader : public Visitor {
+public:
+    Reader(const char* data, std::size_t size) : begin_(data), end_(data + size) {
+    }
+
+    explicit Reader(const std::string& data) : Reader(data.data(), data.size()) {
+    }
+
+    template <typename T>
+    void apply(T& res) {
+        applyVisitor(res, *this, RootNodeTag());
+    }
+
+    template <typename T>
+    void apply(T& res, std::uint32_t fieldNumber) {
+        scan(begin_, end_, FieldSet(fieldNumber));
+        applyVisitor(res, *this, FieldNumberTag{fieldNumber});
+    }
+
+    template <typename Value, typename Tag>
+    void onValue(Value& v, Tag tag) {
+        readField(field(tag), v);
+    }
+
+    template <typename Value>
+    void onValue(Value& v, SequenceItemTag tag) {
+        if (tuple_) {
+            readField(field(tag), v);
+        } else {
+            readItem(v);
+        }
+    }
+
+    template <typename Container, typename Tag>
+    bool onBlob(BasicBlob<Container>& blob, Tag tag) {
+        const Field* f = field(tag);
+        if (!f) {
+            blob.data.clear();
+        } else if (f->type != lengthDelimitedType) {
+            throw expected<Error>("bytes");
+        } else {
+            blob.data.assign(f->data, f->data + f->value);
+        }
+        return true;
+    }
+
+    template <typename Struct>
+    Reader onStructStart(Struct& , RootNodeTag) {
+        return messageAt(begin_, end_, fieldSet(static_cast<Struct*>(nullptr)));
+    }
+
+    template <typename Struct, typename Tag>
+    Reader onStructStart(Struct& , Tag tag) {
+        return messageAt(field(tag), fieldSet(static_cast<Struct*>(nullptr)));
+    }
+
+    /**
+     * Inserts the keys of the entries, the values are read by the returned
+     * reader as ApplyMapVisitor visits them: a value tag refers to its key
+     * in the map, so the reader finds the entry by the key address. The last
+     * entry wins for a repeated key.
+     */
+    template <typename Map, typename Tag>
+    Reader onMapStart(Map& m, Tag tag) {
+        checkRepeated(tag);
+        const auto fields = all(number(tag));
+        m.clear();
+        Reader retval(end_);
+        retval.entries_.reserve(static_cast<std::size_t>(fields.second - fields.first));
+        for (const Field* f = fields.first; f != fields.second; ++f) {
+            Reader entry = messageAt(f, entryFieldSet());
+            typename std::remove_const<typename Map::key_type>::type key{};
+            entry.readField(entry.find(1), key);
+            const auto item = m.emplace(std::move(key), typename Map::mapped_type()).first;
+            retval.entries_.emplace_back(&item->first, *f);
+        }
+        std::stable_sort(retval.entries_.begin(), retval.entries_.end(), ByKey());
+        return retval;
+    }
+
+    template <typename Sequence, typename Tag>
+    typename std::enable_if<!is_tuple<Sequence>::value, Reader>::type
+    onSequenceStart(Sequence& s, Tag tag) {
+        checkRepeated(tag);
+        const auto fields = all(number(tag));
+        Reader retval(end_);
+        retval.pos_ = fields.first;
+        retval.last_ = fields.second;
+        resizeSequence(s, itemCount<typename boost::range_value<Sequence>::type>(fields.first, fields.second), 0);
+        return retval;
+    }
+
+    template <typename Sequence, typename Tag>
+    typename std::enable_if<is_tuple<Sequence>::value, Reader>::type
+    onSequenceStart(Sequence& , Tag tag) {
+        Reader retval = messageAt(field(tag), fieldSet(static_cast<Sequence*>(nullptr)));
+        retval.tuple_ = true;
+        return retval;
+    }
+
+    template <typename P, typename Tag>
+    bool onOptional(boost::optional<P>& p, Tag tag) {
+        return reset(p, find(number(tag)) != nullptr);
+    }
+
+    template <typename P>
+    bool onOptional(boost::optional<P>& p, SequenceItemTag) {
+        return reset(p, present());
+    }
+
+    template <typename Pointer, typename Tag>
+    bool onSmartPointer(Pointer& p, Tag tag) {
+        return resetPointer(p, find(number(tag)) != nullptr);
+    }
+
+    template <typename Pointer>
+    bool onSmartPointer(Pointer& p, SequenceItemTag) {
+        return resetPointer(p, present());
+    }
+
+private:
+    using Fields = boost::container::small_vector<Field, 16>;
+    using Entry = std::pair<const void*, Field>;
+
+    struct ByKey {
+        bool operator()(const Entry& a, const Entry& b) const { return a.first < b.first; }
+        bool operator()(const void* a, const Entry& b) const { return a < b.first; }
+    };
+
+    explicit Reader(const char* end) : end_(end) {
+    }
+
+    Reader messageAt(const char* p, const char* end, const FieldSet& known) const {
+        Reader retval(end_);
+        retval.scan(p, end, known);
+        return retval;
+    }
+
+    /**
+     * A missing message is empty, so all its members are reset.
+     */
+    Reader messageAt(const Field* f, const FieldSet& known) const {
+        if (!f) {
+            return Reader(end_);
+        }
+        if (f->type != lengthDelimitedType) {
+            throw expected<Error>("message");
+        }
+        return messageAt(f->data, f->data + f->value, known);
+    }
+
+    void scan(const char* p, const char* end, const FieldSet& known) {
+        while (p != end) {
+            const std::uint64_t key = readVarint(p, end);
+            Field f{static_cast<std::uint32_t>(key >> 3), static_cast<WireType>(key & 7), 0, nullptr};
+            if (f.number == 0 || (key >> 3) > std::numeric_limits<std::uint32_t>::max()) {
+                throw ProtobufReaderError("protobuf::Reader error: invalid field number");
+            }
+            switch (f.type) {
+            case varintType:
+                f.value = readVarint(p, end);
+                break;
+            case fixed64Type:
+                f.value = readFixed(p, end, 8);
+                break;
+            case fixed32Type:
+                f.value = readFixed(p, end, 4);
+                break;
+            case lengthDelimitedType:
+                f.value = readVarint(p, end);
+                require<Error>(p, end, f.value);
+                f.data = p;
+                p += f.value;
+                break;
+            default:
+                throw ProtobufReaderError("protobuf::Reader error: unsupported wire type");
+            }
+            if (known.contains(f.number)) {
+                fields_.push_back(f);
+            }
+        }
+        if (!std::is_sorted(fields_.begin(), fields_.end(), ByNumber())) {
+            std::stable_sort(fields_.begin(), fields_.end(), ByNumber());
+        }
+    }
+
+    std::pair<const Field*, const Field*> all(std::uint32_t number) const {
+        const auto range = std::equal_range(fields_.begin(), fields_.end(), number, ByNumber());
+        return {fields_.data() + (range.first - fields_.begin()), fields_.data() + (range.second - fields_.begin())};
+    }
+
+    const Field* find(std::uint32_t number) const {
+        const auto range = all(number);
+        return range.first == range.second ? nullptr : range.second - 1;
+    }
+
+    template <typename Name>
+    static std::uint32_t number(NamedItemTag<Name>) {
+        return members::protobuf_field_number<Name>::value;
+    }
+
+    static std::uint32_t number(FieldNumberTag tag) {
+        return tag.number;
+    }
+
+    /**
+     * The value of a map entry, the fields of the entry are scanned when its
+     * first hook comes.
+     */
+    template <typename Key>
+    std::uint32_t number(NamedItemTag<TagValue<Key>> tag) {
+        const void* key = &tag.name;
+        if (key != entryKey_) {
+            const auto entry = std::upper_bound(entries_.begin(), entries_.end(), key, ByKey());
+            if (entry == entries_.begin() || (entry - 1)->first != key) {
+                throw ProtobufReaderError("protobuf::Reader error: map entry out of range");
+            }
+            const Field& f = (entry - 1)->second;
+            fields_.clear();
+            scan(f.data, f.data + f.value, entryFieldSet());
+            entryKey_ = key;
+        }
+        return 2;
+    }
+
+    std::uint32_t number(SequenceItemTag) {
+        return ++field_;
+    }
+
+    template <typename Tag>
+    const Field* field(Tag tag) {
+        return find(number(tag));
+    }
+
+    const Field* field(SequenceItemTag tag) {
+        return tuple_ ? find(number(tag)) : take();
+    }
+
+    template <typename Tag>
+    void checkRepeated(Tag) const {
+    }
+
+    void checkRepeated(SequenceItemTag) const {
+        if (!tuple_) {
+            throw ProtobufReaderError("protobuf::Reader error: a repeated field of repeated fields");
+        }
+    }
+
+    const Field* next() const {
+        if (pos_ == last_) {
+            throw ProtobufReaderError("protobuf::Reader error: sequence item out of range");
+        }
+        return pos_;
+    }
+
+    const Field* take() {
+        const Field* retval = next();
+        ++pos_;
+        return retval;
+    }
+
+    /**
+     * An item of a tuple may be missing, a repeated field has only the
+     * present items.
+     */
+    bool present() {
+        if (!tuple_) {
+            return true;
+        }
+        if (!find(field_ + 1)) {
+            ++field_;
+            return false;
+        }
+        return true;
+    }
+
+    template <typename Item>
+    static typename std::enable_if<std::is_arithmetic<Item>::value, std::size_t>::type
+    itemCount(const Field* first, const Field* last) {
+        std::size_t retval = 0;
+        for (; first != last; ++first) {
+            retval += first->type == lengthDelimitedType ? packedCount<Item>(*first) : 1;
+        }
+        return retval;
+    }
+
+    template <typename Item>
+    static typename std::enable_if<!std::is_arithmetic<Item>::value, std::size_t>::type
+    itemCount(const Field* first, const Field* last) {
+        return static_cast<std::size_t>(last - first);
+    }
+
+    template <typename Value>
+    void readField(const Field* f, Value& v) {
+        if (f) {
+            readValue(*f, v);
+        } else {
+            v = Value();
+        }
+    }
+
+    template <typename Value>
+    typename std::enable_if<std::is_arithmetic<Value>::value>::type
+    readItem(Value& v) {
+        while (!packed_ && next()->type == lengthDelimitedType && pos_->value == 0) {
+            ++pos_;
+        }
+        if (!packed_ && next()->type != lengthDelimitedType) {
+            readValue(*take(), v);
+            return;
+        }
+        const char* end = pos_->data + pos_->value;
+        if (!packed_) {
+            packed_ = pos_->data;
+        }
+        readValue(packedItem<Value>(packed_, end), v);
+        if (packed_ == end) {
+            packed_ = nullptr;
+            ++pos_;
+        }
+    }
+
+    template <typename Value>
+    typename std::enable_if<!std::is_arithmetic<Value>::value>::type
+    readItem(Value& v) {
+        readValue(*take(), v);
+    }
+
+    template <typename P>
+    static bool reset(boost::optional<P>& p, bool present) {
+        if (present) {
+            p = P();
+        } else {
+            p = boost::none;
+        }
+        return present;
+    }
+
+    template <typename Pointer>
+    static bool resetPointer(Pointer& p, bool present) {
+        if (present) {
+            p.reset(new typename Pointer::element_type);
+        } else {
+            p.reset();
+        }
+        return present;
+    }
+
+    const char* begin_ = nullptr;
+    const char* end_ = nullptr;
+    Fields fields_;
+    const Field* pos_ = nullptr;
+    const Field* last_ = nullptr;
+    const char* packed_ = nullptr;
+    std::uint32_t field_ = 0;
+    bool tuple_ = false;
+    std::vector<Entry> entries_;
+    const void* entryKey_ = nullptr;
+};
+
+} // namespace protobuf
+
+/**
+ * Reads the protobuf message into the adapted struct.
+ */
+template <typename T>
+inline void fromProtobuf(const std::string& data, T& v) {
+    protobuf::Reader(data).apply(v);
+}
+
+template <typename T>
+inline T fromProtobuf(const std::string& data) {
+    T retval;
+    fromProtobuf(data, retval);
+    return retval;
+}
+
+template <typename T>
+inline void fromProtobuf(const char* data, std::size_t size, T& v) {
+    protobuf::Reader(data, size).apply(v);
+}
+
+/**
+ * Reads a length delimited record of a toChunkedProtobuf stream from the
+ * data. Returns the end of the record, or nullptr if the data ends before
+ * it and more data is needed.
+ */
+template <typename T>
+inline const char* fromDelimitedProtobuf(const char* data, const char* end, T& v) {
+    std::uint64_t size = 0;
+    for (unsigned shift = 0;; shift += 7) {
+        if (data == end) {
+            return nullptr;
+        }
+        if (shift == 7 * protobuf::maxVarintSize) {
+            throw ProtobufReaderError("protobuf::Reader error: varint is too long");
+        }
+        const auto byte = static_cast<unsigned char>(*data++);
+        size |= std::uint64_t(byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            break;
+        }
+    }
+    if (static_cast<std::uint64_t>(end - data) < size) {
+        return nullptr;
+    }
+    fromProtobuf(data, static_cast<std::size_t>(size), v);
+    return data + size;
+}
+
+/**
+ * Reads the field with the given number of the message, e.g. a sequence from
+ * a repeated field of the root message.
+ */
+template <typename T>
+inline T fromProtobuf(const std::string& data, std::uint32_t fieldNumber) {
+    T retval;
+    protobuf::Reader(data).apply(retval, fieldNumber);
+    return retval;
+}
+
+}}}
+
+#endif // __PROTOBUF_READER_H_
@@ -4,7 +4,10 @@
 #include <stack>
 
 #include <yamail/data/reflection/reflection.h>
+#include <yamail/data/common/base64.h>
+#include <yamail/data/common/numeric_translator.h>
 #include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/stream_translator.hpp>
 
 namespace yamail { namespace data { namespace deserialization {
 
@@ -15,9 +18,18 @@ namespace property_tree {
 
 struct RootNodeTag {};
 
+/**
+ * Arithmetic values are parsed by the locale-free common::NumericTranslator,
+ * everything else goes through the default ptree translator.
+ */
+template <typename Value>
+using Translator = typename std::conditional<std::is_arithmetic<Value>::value,
+        common::NumericTranslator<Value>,
+        typename boost::property_tree::translator_between<std::string, Value>::type>::type;
+
 class Reader : public Visitor {
 public:
-    explicit Reader ( ptree& pt ) : level_ (&pt), iter_(level().begin()) {
+    explicit Reader ( ptree& pt ) : level_ (&pt), iter_(level().begin()), ordered_(level().not_found()) {
     }
 
     template <typename T>
@@ -27,7 +39,7 @@ public:
 
     template <typename Value, typename ... Args>
     void onValue(Value & p, NamedItemTag<Args...> tag) {
-        p = level().template get<Value>(ptree::path_type(name(tag), '\0') );
+        p = getChild(name(tag)).template get_value<Value>(Translator<Value>());
     }
 
     template <typename Value>
@@ -35,17 +47,27 @@ public:
         if( iter() == level().end() ) {
             throw std::runtime_error("Nameless items iterator out of range in PtreeReader");
         }
-        p = iter()->second.template get_value<Value>();
+        p = iter()->second.template get_value<Value>(Translator<Value>());
         ++iter();
     }
 
+    template <typename Container, typename Tag>
+    bool onBlob(BasicBlob<Container>& blob, Tag tag) {
+        std::string text;
+        onValue(text, tag);
+        if (!common::base64::decode(text.data(), text.size(), blob.data)) {
+            throw boost::property_tree::ptree_bad_data("invalid base64 in PtreeReader", text);
+        }
+        return true;
+    }
+
     template <typename Struct, typename ... Args>
     Reader onStructStart(Struct& , NamedItemTag<Args...> tag) {
-        return Reader( level().get_child(name(tag)) );
+        return Reader( getChild(name(tag)) );
     }
 
     template <typename Struct>
-    Reader onStructStart(Struct& , RootNodeTag) { return *this; }
+    Reader& onStructStart(Struct& , RootNodeTag) { return *this; }
 
     template <typename Struct>
     Reader onStructStart(Struct& , SequenceItemTag) {
@@ -55,9 +77,13 @@ public:
     template <typename Map, typename Tag>
     Reader onMapStart(Map & p, Tag tag) {
         auto retval = onStructStart(p, tag);
-        for( const auto & i : retval.level()) {
-            p[i.first];
+        const auto end = retval.level().not_found();
+        for( auto i = retval.level().ordered_begin(); i != end; ++i) {
+            p.emplace_hint(p.end(), std::piecewise_construct,
+                    std::forward_as_tuple(i->first), std::forward_as_tuple());
         }
+        retval.ordered_ = retval.level().ordered_begin();
+        retval.byKey_ = true;
         return std::move(retval);
     }
 
@@ -69,7 +95,7 @@ public:
     }
 
     template <typename Sequence, std::size_t N, typename Tag>
-    Reader onSequenceStart(Sequence (& p)[N], Tag tag) {
+    auto onSequenceStart(Sequence (& p)[N], Tag tag) -> decltype(this->onStructStart(p, tag)) {
         return onStructStart(p, tag);
     }
 
@@ -87,7 +113,7 @@ public:
 
     template<typename Pointer, typename ... Args>
     bool onSmartPointer(Pointer& p, NamedItemTag<Args...> tag) {
-        const bool fieldFound = ( level().find( name(tag) ) != level().not_found() );
+        const bool fieldFound = ( findChild(name(tag)) != nullptr );
         if( fieldFound ) {
             p.reset(new typename Pointer::element_type);
         }
@@ -120,14 +146,67 @@ private:
     ptree & level() const { return *level_; }
     ptree::iterator & iter() { return iter_; }
 
+    /**
+     * Struct fields usually come in the declaration order and map items are
+     * visited in the key order, so the child is looked for at the cursor
+     * (the document order one for structs, the key order one for maps) and
+     * right after it first; the ptree key index is used only when the order
+     * differs. The cursor stays at the found child, so the repeated lookup of
+     * the same name for an optional or a pointer is free as well.
+     */
+    template <typename Name>
+    ptree* findChild(const Name& name) {
+        if (byKey_ ? seek(ordered_, level().not_found(), name) : seek(iter_, level().end(), name)) {
+            return byKey_ ? &ordered_->second : &iter_->second;
+        }
+        const auto i = level().find(name);
+        if (i == level().not_found()) {
+            return nullptr;
+        }
+        if (byKey_) {
+            ordered_ = i;
+        } else {
+            iter_ = level().to_iterator(i);
+        }
+        return &i->second;
+    }
+
+    template <typename Name>
+    ptree& getChild(const Name& name) {
+        ptree* retval = findChild(name);
+        if (!retval) {
+            const std::string key(name);
+            throw boost::property_tree::ptree_bad_path("No such node (" + key + ")", ptree::path_type(key, '\0'));
+        }
+        return *retval;
+    }
+
+    template <typename Iterator, typename Name>
+    static bool seek(Iterator& cursor, Iterator end, const Name& name) {
+        if (cursor == end) {
+            return false;
+        }
+        if (cursor->first == name) {
+            return true;
+        }
+        const auto next = std::next(cursor);
+        if (next != end && next->first == name) {
+            cursor = next;
+            return true;
+        }
+        return false;
+    }
+
     std::string defaultValueName = "value";
     ptree* level_ = nullptr;
     ptree::iterator iter_;
+    ptree::assoc_iterator ordered_;
+    bool byKey_ = false;
 
     template <typename P, typename ... Args>
     bool onOptionalIntegral(boost::optional<P> & p, NamedItemTag<Args...> tag) {
-        const bool optFieldFound = ( level().find( name(tag) ) != level().not_found() );
-        const bool hasValue = optFieldFound && !level().get_child(name(tag)).data().empty();
+        const ptree* child = findChild(name(tag));
+        const bool hasValue = child && !child->data().empty();
         if( hasValue ) {
             p = P();
         }
@@ -146,7 +225,7 @@ private:
 
     template <typename P, typename ... Args>
     bool onOptionalImpl(boost::optional<P> & p, NamedItemTag<Args...> tag) {
-        const bool optFieldFound = (level().find( name(tag) ) != level().not_found());
+        const bool optFieldFound = ( findChild(name(tag)) != nullptr );
         if( optFieldFound ) {
             p = P();
         }
@@ -0,0 +1,184 @@
+#ifndef __FIELD_MASK_H_
+#define __FIELD_MASK_H_
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include <boost/fusion/include/size.hpp>
+#include <boost/mpl/or.hpp>
+
+#include <yamail/data/reflection/reflection.h>
+#include <yamail/data/reflection/field_table.h>
+
+namespace yamail { namespace data { namespace reflection {
+
+class FieldMaskError : public std::invalid_argument {
+public:
+    FieldMaskError(const std::string& msg) : std::invalid_argument(msg) {}
+};
+
+namespace members {
+
+template <typename T>
+struct masked_struct;
+
+template <typename T>
+struct masked_struct_of_mapped {
+    using type = typename masked_struct<typename T::mapped_type>::type;
+};
+
+template <typename T>
+struct masked_struct_of_value {
+    using type = typename masked_struct<typename T::value_type>::type;
+};
+
+template <typename T>
+struct masked_struct_of_element {
+    using type = typename masked_struct<typename T::element_type>::type;
+};
+
+template <typename T>
+struct masked_struct_of_extent {
+    using type = typename masked_struct<typename boost::remove_extent<T>::type>::type;
+};
+
+/**
+ * The adapted type a member of type T leads to - through sequences, map
+ * values, optionals and pointers, the way SelectType visits them - or void
+ * if it has no members to mask.
+ */
+template <typename T>
+struct masked_struct {
+    using D = typename boost::remove_cv<T>::type;
+
+    template <typename CondT, typename ThenT, typename ElseT>
+    using If = boost::mpl::eval_if< CondT, ThenT, ElseT >;
+
+    using None = boost::mpl::identity<void>;
+
+    using type = typename
+    If< has_iterator<D>,
+        If< boost::is_same<D, std::string>,
+            None,
+        If< has_mapped_type<D>,
+            masked_struct_of_mapped<D>,
+        If< is_arithmetic_range<D>,
+            None,
+            masked_struct_of_value<D>
+        >>>,
+    If< boost::is_class<D>,
+        If< boost::mpl::or_<is_pair<D>, is_blob<D>, is_tuple<D>>,
+            None,
+        If< is_smart_ptr<D>,
+            masked_struct_of_element<D>,
+        If< is_optional<D>,
+            masked_struct_of_value<D>,
+            boost::mpl::identity<D>
+        >>>,
+    If< boost::is_array<D>,
+        masked_struct_of_extent<D>,
+        None
+    >>>::type;
+};
+
+/**
+ * The type of the N-th member of the adapted type T, the getter result type
+ * for an ADT method.
+ */
+template <typename T, int N>
+struct member_type {
+    using item = typename std::decay<typename boost::fusion::result_of::at_c<T, N>::type>::type;
+    using type = typename boost::mpl::eval_if<
+            boost::mpl::or_<is_adt_setter<item>, is_adt_getter<item>>,
+            adt_setter_buffer<item>, std::decay<item>>::type;
+};
+
+namespace detail {
+
+template <typename T>
+void includeField(FieldMask& mask, const char* first, const char* last, const std::string& path);
+
+template <typename T>
+inline typename std::enable_if<std::is_void<T>::value>::type
+includeSubfield(FieldMask&, const char*, const char*, const std::string& path) {
+    throw FieldMaskError("field \"" + path + "\" has no members to select");
+}
+
+template <typename T>
+inline typename std::enable_if<!std::is_void<T>::value>::type
+includeSubfield(FieldMask& mask, const char* first, const char* last, const std::string& path) {
+    includeField<T>(mask, first, last, path);
+}
+
+/**
+ * Descends into the member with the run-time index.
+ */
+template <typename T, int N = 0, int Size = boost::fusion::result_of::size<T>::value>
+struct IncludeSubfield {
+    static void apply(std::size_t index, FieldMask& mask, const char* first, const char* last,
+            const std::string& path) {
+        if (index == N) {
+            using Member = typename masked_struct<typename member_type<T, N>::type>::type;
+            includeSubfield<Member>(mask, first, last, path);
+        } else {
+            IncludeSubfield<T, N + 1, Size>::apply(index, mask, first, last, path);
+        }
+    }
+};
+
+template <typename T, int Size>
+struct IncludeSubfield<T, Size, Size> {
+    static void apply(std::size_t, FieldMask&, const char*, const char*, const std::string&) {}
+};
+
+template <typename T>
+inline void includeField(FieldMask& mask, const char* first, const char* last, const std::string& path) {
+    const char* const dot = std::find(first, last, '.');
+    const std::size_t index = fieldTable<T>().find(first, static_cast<std::size_t>(dot - first));
+    if (index == FieldTable::npos) {
+        throw FieldMaskError("unknown field \"" + path + "\" in the field mask");
+    }
+    mask.include<T>(index);
+    if (dot != last) {
+        IncludeSubfield<T>::apply(index, mask, dot + 1, last, path);
+    }
+}
+
+} // namespace detail
+
+} // namespace members
+
+/**
+ * Compiles the comma separated member paths of the adapted type T, e.g.
+ * "id,subject,recipients.email.address", into a FieldMask. A path goes
+ * through sequences, optionals and pointers right to the members of their
+ * items. The masks are per type, so the paths into the same type add up,
+ * and a member named without a subpath is visited as a whole unless other
+ * paths select some of its members. An empty list selects everything.
+ * Throws FieldMaskError for an unknown member.
+ */
+template <typename T>
+inline FieldMask parseFieldMask(const std::string& fields) {
+    using Type = typename members::masked_struct<T>::type;
+    static_assert(!std::is_void<Type>::value, "parseFieldMask needs an adapted type");
+
+    FieldMask mask;
+    std::string::size_type begin = 0;
+    while (begin < fields.size()) {
+        std::string::size_type end = fields.find(',', begin);
+        if (end == std::string::npos) {
+            end = fields.size();
+        }
+        if (end != begin) {
+            const std::string path = fields.substr(begin, end - begin);
+            members::detail::includeField<Type>(mask, path.data(), path.data() + path.size(), path);
+        }
+        begin = end + 1;
+    }
+    return mask;
+}
+
+}}}
+
+#endif // __FIELD_MASK_H_
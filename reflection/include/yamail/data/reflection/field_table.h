@@ -0,0 +1,174 @@
+#ifndef __FIELD_TABLE_H_
+#define __FIELD_TABLE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <yamail/data/reflection/reflection.h>
+
+namespace yamail { namespace data { namespace reflection {
+
+namespace members {
+
+/**
+ * Names of the members of an adapted type (both BOOST_FUSION_ADAPT_STRUCT
+ * attributes and BOOST_FUSION_ADAPT_ADT methods) with a minimal perfect hash
+ * from a key to the member index, so a key is resolved with one hash and one
+ * memcmp. The hash is "hash and displace": the upper half of the key hash
+ * selects a bucket, the displacement of the bucket is mixed into the lower
+ * half to get the slot. The table is built once per type.
+ */
+class FieldTable {
+public:
+    enum : std::size_t { npos = std::size_t(-1) };
+
+    explicit FieldTable(std::vector<std::string> names)
+    : names_(std::move(names)), displacements_(names_.size()), slots_(names_.size(), npos) {
+        build();
+    }
+
+    std::size_t size() const { return names_.size(); }
+    const std::string& name(std::size_t i) const { return names_[i]; }
+
+    /**
+     * Returns the index of the member with the given name or npos.
+     */
+    std::size_t find(const char* key, std::size_t n) const {
+        if (names_.empty()) {
+            return npos;
+        }
+        const std::uint64_t h = hash(key, n);
+        const std::size_t index = slots_[slot(h, displacements_[bucket(h)])];
+        const std::string& name = names_[index];
+        if (name.size() != n || std::memcmp(name.data(), key, n)) {
+            return npos;
+        }
+        return index;
+    }
+
+    std::size_t find(const std::string& key) const {
+        return find(key.data(), key.size());
+    }
+
+    static std::uint64_t hash(const char* key, std::size_t n) {
+        std::uint64_t h = 14695981039346656037ull;
+        for (std::size_t i = 0; i < n; ++i) {
+            h = (h ^ static_cast<unsigned char>(key[i])) * 1099511628211ull;
+        }
+        return h;
+    }
+
+private:
+    std::size_t bucket(std::uint64_t h) const {
+        return (h >> 32) % names_.size();
+    }
+
+    std::size_t slot(std::uint64_t h, std::uint32_t displacement) const {
+        std::uint32_t x = static_cast<std::uint32_t>(h) ^ (displacement * 0x9e3779b9u);
+        x ^= x >> 16;
+        x *= 0x85ebca6bu;
+        x ^= x >> 13;
+        x *= 0xc2b2ae35u;
+        x ^= x >> 16;
+        return x % names_.size();
+    }
+
+    void build() {
+        std::vector<std::string> sorted(names_);
+        std::sort(sorted.begin(), sorted.end());
+        const auto duplicate = std::adjacent_find(sorted.begin(), sorted.end());
+        if (duplicate != sorted.end()) {
+            throw std::logic_error("duplicate member name \"" + *duplicate + "\" in FieldTable");
+        }
+
+        const std::size_t n = names_.size();
+        std::vector<std::vector<std::size_t>> buckets(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            buckets[bucket(hash(names_[i]))].push_back(i);
+        }
+        std::vector<std::size_t> order(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+            return buckets[a].size() > buckets[b].size();
+        });
+
+        std::vector<std::size_t> taken;
+        for (const auto b : order) {
+            const auto& items = buckets[b];
+            if (items.empty()) {
+                break;
+            }
+            for (std::uint32_t d = 0; d != maxDisplacement; ++d) {
+                taken.clear();
+                for (const auto i : items) {
+                    const std::size_t s = slot(hash(names_[i]), d);
+                    if (slots_[s] != npos || std::count(taken.begin(), taken.end(), s)) {
+                        break;
+                    }
+                    taken.push_back(s);
+                }
+                if (taken.size() == items.size()) {
+                    displacements_[b] = d;
+                    for (std::size_t k = 0; k < items.size(); ++k) {
+                        slots_[taken[k]] = items[k];
+                    }
+                    break;
+                }
+            }
+            if (taken.size() != items.size()) {
+                throw std::logic_error("can not find the perfect hash for \"" + names_[items.front()] + "\" in FieldTable");
+            }
+        }
+    }
+
+    static std::uint64_t hash(const std::string& s) {
+        return hash(s.data(), s.size());
+    }
+
+    static constexpr std::uint32_t maxDisplacement = 1u << 20;
+
+    std::vector<std::string> names_;
+    std::vector<std::uint32_t> displacements_;
+    std::vector<std::size_t> slots_;
+};
+
+namespace detail {
+
+struct NamesCollector {
+    std::vector<std::string>& names;
+
+    template <typename Name>
+    void operator()(const Name&) const {
+        names.emplace_back(Name::call());
+    }
+};
+
+template <typename T>
+inline FieldTable makeFieldTable() {
+    std::vector<std::string> names;
+    boost::fusion::for_each(names::make_vector<T>(), NamesCollector{names});
+    return FieldTable(std::move(names));
+}
+
+} // namespace detail
+
+/**
+ * The table of the adapted type T, indices follow the adaptation order.
+ */
+template <typename T>
+inline const FieldTable& fieldTable() {
+    static const FieldTable table = detail::makeFieldTable<typename std::decay<T>::type>();
+    return table;
+}
+
+} // namespace members
+
+}}}
+
+#endif // __FIELD_TABLE_H_
@@ -0,0 +1,80 @@
+#ifndef __PROTOBUF_FIELDS_H_
+#define __PROTOBUF_FIELDS_H_
+
+#include <cstdint>
+#include <utility>
+
+#include <boost/fusion/include/size.hpp>
+
+#include <yamail/data/reflection/reflection.h>
+
+namespace yamail { namespace data { namespace reflection {
+
+/**
+ * Protobuf field numbers of the members of an adapted type, in the
+ * adaptation order. A type opts in by YR_PROTOBUF_FIELDS after its
+ * BOOST_FUSION_ADAPT_STRUCT or BOOST_FUSION_ADAPT_ADT.
+ */
+template <typename T>
+struct protobuf_fields;
+
+template <typename T1, typename T2>
+struct protobuf_fields<std::pair<T1, T2>> {
+    static const std::uint32_t* numbers() {
+        static const std::uint32_t values[] = {1, 2};
+        return values;
+    }
+};
+
+#define YR_PROTOBUF_FIELDS(Type, ...) \
+    namespace yamail { namespace data { namespace reflection { \
+    template <> \
+    struct protobuf_fields<Type> { \
+        static const std::uint32_t* numbers() { \
+            static const std::uint32_t values[] = {__VA_ARGS__}; \
+            static_assert(sizeof(values) / sizeof(values[0]) == boost::fusion::result_of::size<Type>::value, \
+                    "YR_PROTOBUF_FIELDS needs a number for every member of " #Type); \
+            return values; \
+        } \
+    }; \
+    }}}
+
+namespace members {
+
+/**
+ * The adapted type and the index of the member a NamedItemTag name refers
+ * to, both for an attribute and for an ADT method.
+ */
+template <typename Name>
+struct member_of;
+
+template <typename T, int N>
+struct member_of<boost::fusion::extension::struct_member_name<T, N>> {
+    using type = T;
+    static constexpr int index = N;
+};
+
+template <typename T, typename N, typename Name>
+struct member_of<names::method_impl<T, N, Name>> {
+    using type = T;
+    static constexpr int index = N::value;
+};
+
+/**
+ * The field number of the member named by the Name type of a NamedItemTag,
+ * looked up once per member.
+ */
+template <typename Name>
+struct protobuf_field_number {
+    static const std::uint32_t value;
+};
+
+template <typename Name>
+const std::uint32_t protobuf_field_number<Name>::value =
+        protobuf_fields<typename member_of<Name>::type>::numbers()[member_of<Name>::index];
+
+} // namespace members
+
+}}}
+
+#endif // __PROTOBUF_FIELDS_H_
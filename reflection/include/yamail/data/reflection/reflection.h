@@ -1,7 +1,12 @@
 #ifndef __REFLECTION_H_
 #define __REFLECTION_H_
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <iostream>
+#include <vector>
 
 #include <boost/type_traits.hpp>
 #include <boost/function.hpp>
@@ -27,11 +32,16 @@
 
 #include <boost/mpl/has_xxx.hpp>
 
+#include <boost/preprocessor/punctuation/comma_if.hpp>
+#include <boost/preprocessor/repetition/repeat.hpp>
+
 #include <boost/smart_ptr.hpp>
 #include <boost/optional.hpp>
 
 #include <boost/range/algorithm.hpp>
 
+#include <boost/dynamic_bitset.hpp>
+
 namespace yamail { namespace data { namespace reflection {
 
 
@@ -127,12 +137,98 @@ struct ApplySequenceVisitor {
 
     template <typename Tag>
     static void apply(T & cont, Visitor & v, Tag tag) {
-        auto itemVisitor = v.onSequenceStart(cont, tag);
+        auto&& itemVisitor = v.onSequenceStart(cont, tag);
         boost::for_each(cont, makeApplier(itemVisitor, SequenceItemTag{}));
         v.onSequenceEnd(cont, tag);
     }
 };
 
+template <class T>
+struct is_arithmetic_item
+        : public boost::mpl::bool_<boost::is_arithmetic<T>::value && !boost::is_same<T, bool>::value> { };
+
+/**
+ * Contiguous sequences of arithmetic values: such a sequence is passed to
+ * the visitor as a whole by onArithmeticRange.
+ */
+template <class T>
+struct is_arithmetic_range : public boost::mpl::false_ { };
+
+template <class T, class Allocator>
+struct is_arithmetic_range<std::vector<T, Allocator> > : public is_arithmetic_item<T> { };
+
+template <class T, std::size_t N>
+struct is_arithmetic_range<std::array<T, N> > : public is_arithmetic_item<T> { };
+
+template <class T, std::size_t N>
+struct is_arithmetic_range<T[N]> : public is_arithmetic_item<T> { };
+
+template <class Range>
+inline auto rangeData(Range& r) -> decltype(r.data()) { return r.data(); }
+
+template <class T, std::size_t N>
+inline T* rangeData(T (&r)[N]) { return r; }
+
+template <class Range>
+inline std::size_t rangeSize(Range& r) { return r.size(); }
+
+template <class T, std::size_t N>
+inline std::size_t rangeSize(T (&)[N]) { return N; }
+
+template <typename T, typename Visitor>
+struct ApplyArithmeticRangeVisitor {
+
+    typedef ApplyArithmeticRangeVisitor<T,Visitor> type;
+
+    template <typename Tag>
+    static void apply(T & cont, Visitor & v, Tag tag) {
+        if (!v.onArithmeticRange(rangeData(cont), rangeSize(cont), tag)) {
+            ApplySequenceVisitor<T, Visitor>::apply(cont, v, tag);
+        }
+    }
+};
+
+/**
+ * Binary data: the serializers write it as a base64 string instead of an
+ * array of small numbers. Wrap a std::vector<std::uint8_t> or
+ * std::vector<char> member into it to opt in.
+ */
+template <typename Container>
+struct BasicBlob {
+    using container_type = Container;
+
+    BasicBlob() = default;
+    BasicBlob(Container data) : data(std::move(data)) {}
+
+    Container data;
+};
+
+template <typename Container>
+inline bool operator==(const BasicBlob<Container>& lhs, const BasicBlob<Container>& rhs) {
+    return lhs.data == rhs.data;
+}
+
+using Blob = BasicBlob<std::vector<std::uint8_t>>;
+
+template <class T>
+struct is_blob : public boost::mpl::false_ { };
+
+template <class Container>
+struct is_blob<BasicBlob<Container> > : public boost::mpl::true_ { };
+
+template <typename T, typename Visitor>
+struct ApplyBlobVisitor {
+
+    typedef ApplyBlobVisitor<T,Visitor> type;
+
+    template <typename Tag>
+    static void apply(T & blob, Visitor & v, Tag tag) {
+        if (!v.onBlob(blob, tag)) {
+            applyVisitor(blob.data, v, tag);
+        }
+    }
+};
+
 template <class T>
 struct is_tuple : public boost::mpl::false_ { };
 
@@ -149,7 +245,7 @@ struct ApplyTupleVisitor {
 
     template <typename Tag>
     static void apply(T & cont, Visitor & v, Tag tag) {
-        auto itemVisitor = v.onSequenceStart(cont, tag);
+        auto&& itemVisitor = v.onSequenceStart(cont, tag);
         boost::fusion::for_each(cont, makeApplier(itemVisitor, SequenceItemTag{}));
         v.onSequenceEnd(cont, tag);
     }
@@ -164,7 +260,7 @@ struct ApplyMapVisitor {
 
     template <typename Tag>
     static void apply(T & cont, Visitor & v, Tag tag) {
-        auto itemVisitor = v.onMapStart(cont, tag);
+        auto&& itemVisitor = v.onMapStart(cont, tag);
         boost::for_each(cont, makeApplier(itemVisitor, MapItemTag{}));
         v.onMapEnd(cont, tag);
     }
@@ -177,20 +273,33 @@ inline std::string stripMethodName(std::string name) {
 }
 
 #define YR_GET_WITH_SPECIFIC_NAME(fun, name)\
-    std::make_pair(name, obj.fun())
+    yamail::data::reflection::members::makeGetterPair(name, obj.fun())
 
 // Deprecated
 #define YR_CALL_WITH_SPECIFIC_NAME(fun, name) YR_GET_WITH_SPECIFIC_NAME(fun, name)
 
+#define YR_STATIC_NAME_LIMIT 64
+
+#define YR_STATIC_NAME_CHAR(z, i, str) BOOST_PP_COMMA_IF(i) (i < sizeof(str) ? str[i] : '\0')
+
+/**
+ * Compile-time name made of a string literal, its length is limited by
+ * YR_STATIC_NAME_LIMIT.
+ */
+#define YR_STATIC_NAME(str) \
+    ::yamail::data::reflection::members::names::staticName<sizeof(str)>( \
+        ::yamail::data::reflection::members::names::StaticName< \
+            BOOST_PP_REPEAT(YR_STATIC_NAME_LIMIT, YR_STATIC_NAME_CHAR, str) >())
+
 #define YR_GET_WITH_NAME(fun) \
-    YR_CALL_WITH_SPECIFIC_NAME(fun, #fun)
+    YR_CALL_WITH_SPECIFIC_NAME(fun, YR_STATIC_NAME(#fun))
 
 // Deprecated
 #define YR_CALL_WITH_NAME(fun) \
     YR_CALL_WITH_SPECIFIC_NAME(fun, stripMethodName(#fun))
 
 #define YR_SET_WITH_NAME(fun) \
-    obj.fun( val.second );
+    obj.fun( yamail::data::reflection::members::setterArg(val) );
 
 // Deprecated
 #define YR_CALL_SET_WITH_NAME(fun) YR_SET_WITH_NAME(fun)
@@ -209,6 +318,49 @@ struct is_adt_getter : boost::mpl::false_ {};
 template <typename T, int N>
 struct is_adt_getter<boost::fusion::extension::adt_attribute_proxy<T, N, true>> : boost::mpl::true_ {};
 
+/**
+ * The pair of a getter keeps the reference if the getter returns one, so
+ * the value is visited in place instead of being copied.
+ */
+template <typename Name, typename Value>
+inline std::pair<Name, Value> makeGetterPair(Name name, Value&& value) {
+    return std::pair<Name, Value>(std::move(name), std::forward<Value>(value));
+}
+
+/**
+ * The value an ADT setter is deserialized into - a default constructed object
+ * of the getter result type, even if the getter pair holds a reference.
+ */
+template <typename Proxy>
+struct adt_setter_buffer {
+    using pair = typename std::decay<typename Proxy::type>::type;
+    using type = typename std::decay<typename pair::second_type>::type;
+};
+
+/**
+ * Passes the deserialized buffer to an ADT setter, YR_SET_WITH_NAME moves the
+ * value out of it. Custom setter expressions see the buffer as val.second.
+ */
+template <typename Value>
+struct setter_value {
+    Value& second;
+};
+
+template <typename Value>
+inline setter_value<Value> moveToSetter(Value& value) {
+    return setter_value<Value>{value};
+}
+
+template <typename Value>
+inline Value&& setterArg(const setter_value<Value>& val) {
+    return std::move(val.second);
+}
+
+template <typename Pair>
+inline auto setterArg(const Pair& val) -> decltype((val.second)) {
+    return val.second;
+}
+
 namespace names {
 
 template <typename T, typename N>
@@ -217,15 +369,57 @@ struct attribute {
             typename boost::remove_const<T>::type , N::value>;
 };
 
+/**
+ * Name of a YR_GET_WITH_NAME getter - the characters are the template
+ * arguments, so the name is known without an object.
+ */
+template <char ... C>
+struct StaticName {
+    static constexpr char value[] = {C..., '\0'};
+
+    static constexpr const char* call() { return value; }
+    operator std::string () const { return value; }
+};
+
+template <char ... C>
+constexpr char StaticName<C...>::value[];
+
+template <std::size_t Size, typename Name>
+inline Name staticName(Name name) {
+    static_assert(Size <= YR_STATIC_NAME_LIMIT, "the name is longer than YR_STATIC_NAME_LIMIT");
+    return name;
+}
+
 template <typename T, typename N>
-struct method {
-    using type = method;
+using method_name_type = typename std::decay<
+        decltype(boost::fusion::at<N>(std::declval<T&>()).get())>::type::first_type;
+
+/**
+ * Name of an ADT method. A getter with the static name costs nothing,
+ * the other ones (YR_CALL_WITH_NAME, YR_GET_WITH_SPECIFIC_NAME with a run-time
+ * name) still need a default constructed object to evaluate the name.
+ */
+template <typename T, typename N, typename Name>
+struct method_impl {
+    using type = method_impl;
 
     static auto call() -> decltype(boost::fusion::at<N>(T()).get().first) {
         return boost::fusion::at<N>(T()).get().first;
     }
 };
 
+template <typename T, typename N, char ... C>
+struct method_impl<T, N, StaticName<C...>> {
+    using type = method_impl;
+
+    static constexpr const char* call() { return StaticName<C...>::call(); }
+};
+
+template <typename T, typename N>
+struct method {
+    using type = method_impl<T, N, method_name_type<T, N>>;
+};
+
 template <typename T, typename N>
 struct get {
     typedef typename boost::mpl::next<N>::type next;
@@ -271,25 +465,116 @@ using zip_view = boost::fusion::zip_view<boost::fusion::vector<
 
 template <typename Names, typename Struct>
 inline zip_view<Names, Struct> make_view(Names& names, Struct& value) {
-    return zip_view<Names, Struct>({names, value});
+    using Sequences = typename zip_view<Names, Struct>::sequences;
+    return zip_view<Names, Struct>(Sequences(names, value));
 }
 
+/**
+ * The names are empty tag types, so a namespace scope constant is enough -
+ * unlike a function local static it has no initialization guard to check.
+ */
 template <typename T>
-struct make_vector_impl {
-    const typename names::result_of::make_vector<T>::type names = names::make_vector<T>();
-    auto call(T& value) const -> decltype(make_view(names, value)) {
-        return make_view(names, value);
-    }
+struct names_of {
+    static const typename names::result_of::make_vector<T>::type value;
 };
 
 template <typename T>
-static auto make_vector(T& value) -> decltype(make_vector_impl<T>().call(value)) {
-    static make_vector_impl<T> impl;
-    return impl.call(value);
+const typename names::result_of::make_vector<T>::type names_of<T>::value{};
+
+template <typename T>
+inline auto make_vector(T& value) -> decltype(make_view(names_of<T>::value, value)) {
+    return make_view(names_of<T>::value, value);
 }
 
 } // namespace members
 
+/**
+ * Members of the adapted types the visitors walk, made by parseFieldMask of
+ * field_mask.h. Every restricted type has the bitset of its members in the
+ * adaptation order, the other types are visited as a whole. The mask is
+ * active for the current thread within a FieldMaskScope, so every visitor
+ * honours it without carrying it.
+ */
+class FieldMask {
+public:
+    using Fields = boost::dynamic_bitset<>;
+
+    bool empty() const {
+        return std::none_of(fields_.begin(), fields_.end(),
+                [](const Fields& f) { return !f.empty(); });
+    }
+
+    /**
+     * The members of T to visit or nullptr if T is not restricted.
+     */
+    template <typename T>
+    const Fields* fields() const {
+        const std::size_t slot = typeSlot<typename std::decay<T>::type>();
+        return slot < fields_.size() && !fields_[slot].empty() ? &fields_[slot] : nullptr;
+    }
+
+    /**
+     * Restricts T to the members included so far, the index is the member
+     * index in the adaptation order.
+     */
+    template <typename T>
+    void include(std::size_t index) {
+        using Type = typename std::decay<T>::type;
+        const std::size_t slot = typeSlot<Type>();
+        if (slot >= fields_.size()) {
+            fields_.resize(slot + 1);
+        }
+        Fields& f = fields_[slot];
+        if (f.empty()) {
+            f.resize(boost::fusion::result_of::size<Type>::value);
+        }
+        f.set(index);
+    }
+
+    static const FieldMask* current() { return active(); }
+
+private:
+    friend class FieldMaskScope;
+
+    static const FieldMask*& active() {
+        static thread_local const FieldMask* mask = nullptr;
+        return mask;
+    }
+
+    static std::size_t nextSlot() {
+        static std::atomic<std::size_t> next{0};
+        return next++;
+    }
+
+    template <typename T>
+    static std::size_t typeSlot() {
+        static const std::size_t slot = nextSlot();
+        return slot;
+    }
+
+    std::vector<Fields> fields_;
+};
+
+/**
+ * Makes the mask active for the current thread until the end of the scope,
+ * an empty mask costs the visitors nothing.
+ */
+class FieldMaskScope {
+public:
+    explicit FieldMaskScope(const FieldMask& mask)
+    : previous_(FieldMask::active()) {
+        FieldMask::active() = mask.empty() ? nullptr : &mask;
+    }
+
+    FieldMaskScope(const FieldMaskScope&) = delete;
+    FieldMaskScope& operator=(const FieldMaskScope&) = delete;
+
+    ~FieldMaskScope() { FieldMask::active() = previous_; }
+
+private:
+    const FieldMask* previous_;
+};
+
 namespace visit_struct {
 
 template <typename Visitor>
@@ -328,15 +613,40 @@ struct Adaptor {
     template <typename Proxy, typename Tag, typename P = typename std::decay<Proxy>::type>
     typename std::enable_if< members::is_adt_setter<P>::value >::type
     visit(Proxy p, Tag tag) const {
-        typename Proxy::type buf = p;
-        applyVisitor(buf.second, v, tag);
-        p = buf;
+        typename members::adt_setter_buffer<P>::type buf{};
+        applyVisitor(buf, v, tag);
+        p = members::moveToSetter(buf);
     }
 };
 
 template <typename Visitor>
 inline Adaptor<Visitor> adapt(Visitor& v) { return Adaptor<Visitor>{v}; }
 
+/**
+ * Visits the members of the field mask only, the excluded ones - getters
+ * included - are not touched at all.
+ */
+template <typename Visitor>
+struct MaskedAdaptor : Adaptor<Visitor> {
+    const FieldMask::Fields& fields;
+    mutable std::size_t index = 0;
+
+    MaskedAdaptor(Visitor& v, const FieldMask::Fields& fields)
+    : Adaptor<Visitor>{v}, fields(fields) {}
+
+    template <typename View>
+    void operator()(View view) const {
+        if (fields.test(index++)) {
+            Adaptor<Visitor>::operator()(view);
+        }
+    }
+};
+
+template <typename Visitor>
+inline MaskedAdaptor<Visitor> adapt(Visitor& v, const FieldMask::Fields& fields) {
+    return MaskedAdaptor<Visitor>(v, fields);
+}
+
 } // namespace visit_struct
 
 template <typename T, typename Visitor>
@@ -346,8 +656,14 @@ struct ApplyStructVisitor {
     template <typename Tag>
     static void apply (T& value, Visitor& v, Tag tag) {
         auto members = members::make_vector(value);
-        auto itemVisitor = v.onStructStart(value, tag);
-        boost::fusion::for_each(members, visit_struct::adapt(itemVisitor));
+        auto&& itemVisitor = v.onStructStart(value, tag);
+        const FieldMask* mask = FieldMask::current();
+        const FieldMask::Fields* fields = mask ? mask->fields<T>() : nullptr;
+        if (fields) {
+            boost::fusion::for_each(members, visit_struct::adapt(itemVisitor, *fields));
+        } else {
+            boost::fusion::for_each(members, visit_struct::adapt(itemVisitor));
+        }
         v.onStructEnd(value, tag);
     }
 };
@@ -431,12 +747,16 @@ struct SelectType {
             ApplyPodVisitor<T, V>,
         Elif< has_mapped_type<T>,
             ApplyMapVisitor <T, V>,
+        Elif< is_arithmetic_range<Decay<T>>,
+            ApplyArithmeticRangeVisitor <T, V>,
         Else<
             ApplySequenceVisitor <T, V>
-        >>>,
+        >>>>,
     Elif< boost::is_class<T>,
         If< is_pair<Decay<T>>,
             ApplyPairVisitor<T, V>,
+        Elif< is_blob<Decay<T>>,
+            ApplyBlobVisitor<T, V>,
         Elif< is_tuple<Decay<T>>,
             ApplyTupleVisitor<T, V>,
         Elif< is_smart_ptr<Decay<T>>,
@@ -445,9 +765,13 @@ struct SelectType {
             ApplyOptionalVisitor <T, V>,
         Else<
             ApplyStructVisitor <T, V>
-        >>>>>,
+        >>>>>>,
     Elif< boost::is_array<T>,
-        ApplySequenceVisitor <T, V>,
+        If< is_arithmetic_range<Decay<T>>,
+            ApplyArithmeticRangeVisitor <T, V>,
+        Else<
+            ApplySequenceVisitor <T, V>
+        >>,
     Else<
         ApplyPodVisitor<T, V>
     >>>>;
@@ -458,26 +782,46 @@ struct SelectType {
 template <typename T, typename Visitor>
 struct ApplyVisitor : SelectType < T, Visitor >::type {};
 
+/**
+ * Base of the visitors. The on*Start hooks return the visitor of the items:
+ * a new visitor by value if the items need a scope of their own, or a
+ * reference to an existing one (usually *this) to borrow it for the items.
+ */
 class Visitor {
 public:
     template<typename Value, typename Tag>
     void onValue(Value&& , Tag) {}
 
     template<typename Struct, typename Tag>
-    Visitor onStructStart(Struct&&, Tag) { return *this;}
+    Visitor& onStructStart(Struct&&, Tag) { return *this;}
     template<typename Struct, typename Tag>
     void onStructEnd(Struct&&, Tag) {};
 
     template<typename Map, typename Tag>
-    Visitor onMapStart(Map&& , Tag) { return *this;};
+    Visitor& onMapStart(Map&& , Tag) { return *this;};
     template<typename Map, typename Tag>
     void onMapEnd(Map&& , Tag) {};
 
     template<typename Sequence, typename Tag>
-    Visitor onSequenceStart(Sequence&& , Tag) { return *this;}
+    Visitor& onSequenceStart(Sequence&& , Tag) { return *this;}
     template<typename Sequence, typename Tag>
     void onSequenceEnd(Sequence&& , Tag) {}
 
+    /**
+     * Takes the whole contiguous sequence of arithmetic values instead of
+     * onSequenceStart, onValue for each item and onSequenceEnd. Returns
+     * false to have the sequence visited item by item.
+     */
+    template<typename Value, typename Tag>
+    bool onArithmeticRange(Value* , std::size_t, Tag) { return false; }
+
+    /**
+     * Takes a BasicBlob, returns false to have its data visited as a
+     * sequence.
+     */
+    template<typename Blob, typename Tag>
+    bool onBlob(Blob&& , Tag) { return false; }
+
     template<typename Optional, typename Tag>
     bool onOptional(Optional&& p, Tag) { return p.is_initialized(); }
 
@@ -0,0 +1,444 @@
+#ifndef __CBOR_WRITER_H__
+#define __CBOR_WRITER_H__
+
+#include <cstring>
+#include <iterator>
+#include <string>
+
+#include <boost/fusion/include/size.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <yamail/data/reflection/reflection.h>
+#include <yamail/data/common/cbor.h>
+#include <yamail/data/common/numeric_format.h>
+#include <yamail/data/serialization/json_generator.h>
+#include <yamail/data/serialization/json_rope.h>
+
+namespace yamail { namespace data { namespace serialization {
+
+using namespace yamail::data::reflection;
+
+namespace cbor {
+
+using namespace common::cbor;
+
+inline void appendData(std::string& out, const char* s, std::size_t n) {
+    out.append(s, n);
+}
+
+/**
+ * Nothing is escaped in CBOR, so every string of at least the reference
+ * threshold is referenced by the rope instead of being copied.
+ */
+inline void appendData(json::Rope& out, const char* s, std::size_t n) {
+    const std::size_t threshold = out.referenceThreshold();
+    if (threshold && n >= threshold) {
+        out.appendReference(s, n);
+    } else {
+        out.append(s, n);
+    }
+}
+
+inline void appendData(json::ByteCounter& out, const char* s, std::size_t n) {
+    out.append(s, n);
+}
+
+/**
+ * Appends the CBOR items to the Output - a std::string, a json::Rope or a
+ * json::ByteCounter. The integers take the shortest head, float and double
+ * are written as the single and the double precision floats, so the values
+ * come back bit for bit.
+ */
+template <typename Output>
+class BasicGenerator {
+public:
+    explicit BasicGenerator(Output& out) : out(out) {
+    }
+
+    void head(Major major, std::uint64_t v) {
+        char buf[9];
+        std::size_t size = 0;
+        if (v < oneByteArgument) {
+            buf[0] = initialByte(major, static_cast<std::uint8_t>(v));
+        } else if (v <= 0xff) {
+            buf[0] = initialByte(major, oneByteArgument);
+            size = 1;
+        } else if (v <= 0xffff) {
+            buf[0] = initialByte(major, twoBytesArgument);
+            size = 2;
+        } else if (v <= 0xffffffff) {
+            buf[0] = initialByte(major, fourBytesArgument);
+            size = 4;
+        } else {
+            buf[0] = initialByte(major, eightBytesArgument);
+            size = 8;
+        }
+        storeBigEndian(buf + 1, v, size);
+        out.append(buf, size + 1);
+    }
+
+    void mapOpen() { out += initialByte(map, indefiniteLength); }
+    void mapClose() { out += static_cast<char>(breakByte); }
+    void arrayOpen(std::size_t size) { head(array, size); }
+    void boolean(bool v) { out += static_cast<char>(v ? trueByte : falseByte); }
+    void null() { out += static_cast<char>(nullByte); }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type
+    number(T v) {
+        head(unsignedInteger, v);
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+    number(T v) {
+        if (v < 0) {
+            head(negativeInteger, static_cast<std::uint64_t>(-(static_cast<std::int64_t>(v) + 1)));
+        } else {
+            head(unsignedInteger, static_cast<std::uint64_t>(v));
+        }
+    }
+
+    void number(float v) {
+        std::uint32_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        char buf[5] = {static_cast<char>(floatByte)};
+        storeBigEndian(buf + 1, bits, 4);
+        out.append(buf, sizeof(buf));
+    }
+
+    void number(double v) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        char buf[9] = {static_cast<char>(doubleByte)};
+        storeBigEndian(buf + 1, bits, 8);
+        out.append(buf, sizeof(buf));
+    }
+
+    void number(long double v) {
+        number(static_cast<double>(v));
+    }
+
+    template <typename T>
+    void numberArray(const T* data, std::size_t size) {
+        arrayOpen(size);
+        for (std::size_t i = 0; i != size; ++i) {
+            number(data[i]);
+        }
+    }
+
+    void string(const char* s, std::size_t n) {
+        head(textString, n);
+        appendData(out, s, n);
+    }
+
+    void string(const std::string& s) {
+        string(s.data(), s.size());
+    }
+
+    void bytes(const void* data, std::size_t size) {
+        head(byteString, size);
+        appendData(out, static_cast<const char*>(data), size);
+    }
+
+    void raw(const std::string& item) {
+        out.append(item.data(), item.size());
+    }
+
+private:
+    Output& out;
+};
+
+using Generator = BasicGenerator<std::string>;
+
+using RopeGenerator = BasicGenerator<json::Rope>;
+
+inline std::string encodeKey(const char* name) {
+    std::string retval;
+    Generator(retval).string(name, std::strlen(name));
+    return retval;
+}
+
+/**
+ * Text string item of the key named by the Name type of a NamedItemTag,
+ * encoded once per name, i.e. per member of an adapted type.
+ */
+template <typename Name>
+struct key_fragment {
+    static const std::string value;
+};
+
+template <typename Name>
+const std::string key_fragment<Name>::value = encodeKey(Name::call());
+
+/**
+ * Number of the items of a sequence for the definite length array head.
+ */
+template <typename Sequence>
+inline typename std::enable_if<is_tuple<Sequence>::value, std::size_t>::type
+sequenceSize(const Sequence&, int) {
+    return boost::fusion::result_of::size<Sequence>::value;
+}
+
+template <typename Sequence>
+inline auto sequenceSize(const Sequence& s, int) -> decltype(std::size_t(s.size())) {
+    return s.size();
+}
+
+template <typename Sequence>
+inline std::size_t sequenceSize(const Sequence& s, long) {
+    return static_cast<std::size_t>(std::distance(std::begin(s), std::end(s)));
+}
+
+/**
+ * Structs and maps are written as the indefinite length maps with the text
+ * keys: the absent optionals and null pointers are left out the same way
+ * the JSON writer does. Sequences and tuples are the definite length arrays,
+ * an absent item of a sequence is written as null to keep the positions.
+ */
+template <typename Generator>
+class BasicWriter : public Visitor {
+public:
+    explicit BasicWriter(Generator& gen) : gen(gen) {
+    }
+
+    template<typename T, typename Tag>
+    void apply(const T& value, Tag rootName) {
+        gen.mapOpen();
+        applyVisitor(value, *this, rootName);
+        gen.mapClose();
+    }
+
+    template<typename T>
+    void apply(const T & value) {
+        applyVisitor(value, *this, SequenceItemTag());
+    }
+
+    template <typename Value, typename ... Args>
+    typename std::enable_if<common::numeric::is_number<Value>::value>::type
+    onValue(Value v, NamedItemTag<Args...> tag) {
+        addKey(tag);
+        onValue(v, SequenceItemTag{});
+    }
+
+    template <typename Value>
+    typename std::enable_if<common::numeric::is_number<Value>::value>::type
+    onValue(Value v, SequenceItemTag) {
+        gen.number(v);
+    }
+
+    template<typename ...Args>
+    void onValue(bool b, NamedItemTag<Args...> tag) {
+        addKey(tag);
+        onValue(b, SequenceItemTag{});
+    }
+
+    void onValue(bool b, SequenceItemTag) {
+        gen.boolean(b);
+    }
+
+    template<typename ...Args>
+    void onValue(const std::string & s, NamedItemTag<Args...> tag) {
+        addKey(tag);
+        onValue(s, SequenceItemTag{});
+    }
+
+    void onValue(const std::string & s, SequenceItemTag) {
+        gen.string(s);
+    }
+
+    template<typename Value, typename Tag>
+    typename std::enable_if<!common::numeric::is_number<Value>::value>::type
+    onValue(const Value& p, Tag tag) {
+        onValue(boost::lexical_cast<std::string>(p), tag);
+    }
+
+    using Visitor::onArithmeticRange;
+
+    template <typename Value, typename ... Args>
+    typename std::enable_if<common::numeric::is_number<Value>::value, bool>::type
+    onArithmeticRange(const Value* data, std::size_t size, NamedItemTag<Args...> tag) {
+        addKey(tag);
+        return onArithmeticRange(data, size, SequenceItemTag{});
+    }
+
+    template <typename Value>
+    typename std::enable_if<common::numeric::is_number<Value>::value, bool>::type
+    onArithmeticRange(const Value* data, std::size_t size, SequenceItemTag) {
+        gen.numberArray(data, size);
+        return true;
+    }
+
+    template <typename Container, typename ... Args>
+    bool onBlob(const BasicBlob<Container>& blob, NamedItemTag<Args...> tag) {
+        addKey(tag);
+        return onBlob(blob, SequenceItemTag{});
+    }
+
+    template <typename Container>
+    bool onBlob(const BasicBlob<Container>& blob, SequenceItemTag) {
+        gen.bytes(blob.data.data(), blob.data.size());
+        return true;
+    }
+
+    template <typename Optional, typename ... Args>
+    bool onOptional(const Optional& p, NamedItemTag<Args...>) {
+        return p.is_initialized();
+    }
+
+    template <typename Optional>
+    bool onOptional(const Optional& p, SequenceItemTag) {
+        if (!p.is_initialized()) {
+            gen.null();
+        }
+        return p.is_initialized();
+    }
+
+    template <typename Pointer, typename ... Args>
+    bool onSmartPointer(const Pointer& p, NamedItemTag<Args...>) {
+        return p.get();
+    }
+
+    template <typename Pointer>
+    bool onSmartPointer(const Pointer& p, SequenceItemTag) {
+        if (!p.get()) {
+            gen.null();
+        }
+        return p.get();
+    }
+
+    template<typename Struct, typename ... Args>
+    BasicWriter& onStructStart(const Struct& p, NamedItemTag<Args...> tag) {
+        addKey(tag);
+        return onStructStart(p, SequenceItemTag{});
+    }
+
+    template<typename Struct>
+    BasicWriter& onStructStart(const Struct&, SequenceItemTag) {
+        gen.mapOpen();
+        return *this;
+    }
+
+    template<typename Struct, typename Tag>
+    void onStructEnd(const Struct&, Tag) {
+        gen.mapClose();
+    }
+
+    template<typename Map, typename Tag>
+    BasicWriter& onMapStart(const Map& m, Tag tag) {
+        return onStructStart(m, tag);
+    }
+
+    template<typename Map, typename Tag>
+    void onMapEnd(const Map&, Tag) {
+        gen.mapClose();
+    }
+
+    template<typename Seq, typename ... Args>
+    BasicWriter& onSequenceStart(const Seq& seq, NamedItemTag<Args...> tag) {
+        addKey(tag);
+        return onSequenceStart(seq, SequenceItemTag());
+    }
+
+    template<typename Seq>
+    BasicWriter& onSequenceStart(const Seq& seq, SequenceItemTag) {
+        gen.arrayOpen(sequenceSize(seq, 0));
+        return *this;
+    }
+
+    template<typename Seq, typename Tag>
+    void onSequenceEnd(const Seq& , Tag) {
+    }
+
+    template <typename Ptree, typename Tag >
+    void onPtree(const Ptree& tree, Tag tag) {
+        if (tree.size() == 0) {
+            onValue(tree.data(), tag);
+        } else if (tree.front().first.empty()) {
+            auto& v = onSequenceStart(tree, tag);
+            for (const auto& i : tree) {
+                applyVisitor(i.second, v, SequenceItemTag());
+            }
+            onSequenceEnd(tree, tag);
+        } else {
+            auto& v = onMapStart(tree, tag);
+            for (const auto& i : tree) {
+                applyVisitor(i.second, v, namedItemTag(i.first));
+            }
+            onMapEnd(tree, tag);
+        }
+    }
+
+private:
+    template <typename Name>
+    void addKey(NamedItemTag<Name>) {
+        gen.raw(key_fragment<Name>::value);
+    }
+
+    template <typename T>
+    void addKey(const NamedItemTag<TagValue<T>>& tag) {
+        gen.string(name(tag));
+    }
+
+    Generator& gen;
+};
+
+using Writer = BasicWriter<Generator>;
+
+} // namespace cbor
+
+/**
+ * Exact size of the toCbor result, a pass of the same writer over
+ * json::ByteCounter.
+ */
+template <typename T>
+inline std::size_t cborSize(const T& v) {
+    json::ByteCounter counter;
+    cbor::BasicGenerator<json::ByteCounter> gen(counter);
+    cbor::BasicWriter<cbor::BasicGenerator<json::ByteCounter>>(gen).apply(v);
+    return counter.size();
+}
+
+template <typename T>
+inline std::size_t cborSize(const T& v, const std::string& rootName) {
+    json::ByteCounter counter;
+    cbor::BasicGenerator<json::ByteCounter> gen(counter);
+    cbor::BasicWriter<cbor::BasicGenerator<json::ByteCounter>>(gen).apply(v, namedItemTag(rootName));
+    return counter.size();
+}
+
+template <typename T>
+inline std::string toCbor(const T& v) {
+    std::string retval;
+    retval.reserve(cborSize(v));
+    cbor::Generator gen(retval);
+    cbor::Writer(gen).apply(v);
+    return retval;
+}
+
+template <typename T>
+inline std::string toCbor(const T& v, const std::string& rootName) {
+    std::string retval;
+    retval.reserve(cborSize(v, rootName));
+    cbor::Generator gen(retval);
+    cbor::Writer(gen).apply(v, namedItemTag(rootName));
+    return retval;
+}
+
+/**
+ * Writes the value into pooled blocks, the strings of at least
+ * referenceThreshold bytes are referenced by the rope, so v must outlive
+ * the result. Zero threshold copies every string.
+ */
+template <typename T>
+inline json::Rope toCborRope(const T& v, const std::string& rootName, std::size_t referenceThreshold = 0) {
+    json::Rope retval;
+    retval.referenceStrings(referenceThreshold);
+    cbor::RopeGenerator gen(retval);
+    cbor::BasicWriter<cbor::RopeGenerator>(gen).apply(v, namedItemTag(rootName));
+    return retval;
+}
+
+}}}
+
+#endif // __CBOR_WRITER_H__
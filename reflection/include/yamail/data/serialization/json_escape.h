@@ -0,0 +1,144 @@
+#ifndef __JSON_ESCAPE_H__
+#define __JSON_ESCAPE_H__
+
+#include <cstddef>
+#include <string>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace yamail { namespace data { namespace serialization { namespace json {
+
+/**
+ * JSON string escaping compatible with yajl_gen: '"', '\\' and the control
+ * characters are escaped, the rest of the bytes (including '/' and UTF-8
+ * sequences) are copied as is. Clean runs are found with SSE2/AVX2 when the
+ * target supports them and appended with a single memcpy.
+ */
+namespace escape {
+
+inline bool needsEscape(unsigned char c) {
+    return c < 0x20 || c == '"' || c == '\\';
+}
+
+inline const char* findScalar(const char* first, const char* last) {
+    for (; first != last; ++first) {
+        if (needsEscape(static_cast<unsigned char>(*first))) {
+            break;
+        }
+    }
+    return first;
+}
+
+#if defined(__AVX2__)
+
+inline const char* find(const char* first, const char* last) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1f);
+    for (; last - first >= 32; first += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+        const __m256i m = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)),
+                _mm256_cmpeq_epi8(_mm256_min_epu8(v, control), v));
+        const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(m));
+        if (mask) {
+            return first + __builtin_ctz(mask);
+        }
+    }
+    return findScalar(first, last);
+}
+
+#elif defined(__SSE2__)
+
+inline const char* find(const char* first, const char* last) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1f);
+    for (; last - first >= 16; first += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+        const __m128i m = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+                _mm_cmpeq_epi8(_mm_min_epu8(v, control), v));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(m));
+        if (mask) {
+            return first + __builtin_ctz(mask);
+        }
+    }
+    return findScalar(first, last);
+}
+
+#else
+
+inline const char* find(const char* first, const char* last) {
+    return findScalar(first, last);
+}
+
+#endif
+
+template <typename Output>
+inline void append(Output& out, unsigned char c) {
+    static const char hex[] = "0123456789ABCDEF";
+    switch (c) {
+        case '\r': out.append("\\r", 2); break;
+        case '\n': out.append("\\n", 2); break;
+        case '\\': out.append("\\\\", 2); break;
+        case '"': out.append("\\\"", 2); break;
+        case '\f': out.append("\\f", 2); break;
+        case '\b': out.append("\\b", 2); break;
+        case '\t': out.append("\\t", 2); break;
+        default: {
+            const char u[] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf] };
+            out.append(u, sizeof(u));
+        }
+    }
+}
+
+inline std::size_t size(unsigned char c) {
+    switch (c) {
+        case '\r': case '\n': case '\\': case '"': case '\f': case '\b': case '\t': return 2;
+        default: return 6;
+    }
+}
+
+} // namespace escape
+
+/**
+ * Size of the escaped content of the string without quotes.
+ */
+inline std::size_t escapedSize(const char* s, std::size_t n) {
+    const char* const last = s + n;
+    for (;;) {
+        const char* const e = escape::find(s, last);
+        if (e == last) {
+            return n;
+        }
+        n += escape::size(static_cast<unsigned char>(*e)) - 1;
+        s = e + 1;
+    }
+}
+
+/**
+ * Appends the escaped content of the string without quotes to the Output
+ * (std::string or anything with the same append(const char*, size_t)).
+ */
+template <typename Output>
+inline void appendEscaped(Output& out, const char* s, std::size_t n) {
+    const char* const last = s + n;
+    for (;;) {
+        const char* const e = escape::find(s, last);
+        out.append(s, e - s);
+        if (e == last) {
+            return;
+        }
+        escape::append(out, static_cast<unsigned char>(*e));
+        s = e + 1;
+    }
+}
+
+}}}}
+
+#endif // __JSON_ESCAPE_H__
@@ -0,0 +1,355 @@
+#ifndef __JSON_GENERATOR_H__
+#define __JSON_GENERATOR_H__
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <yamail/data/common/base64.h>
+#include <yamail/data/common/numeric_format.h>
+#include <yamail/data/serialization/json_escape.h>
+#include <yamail/data/serialization/json_rope.h>
+
+namespace yamail { namespace data { namespace serialization {
+
+class JsonError : public std::runtime_error {
+public:
+    JsonError(const std::string& msg) : std::runtime_error(msg) {}
+};
+
+namespace json {
+
+/**
+ * Object key known at compile time with the text written before its value:
+ * the separator, the quoted and escaped name and the colon.
+ */
+struct KeyFragment {
+    explicit KeyFragment(std::string n) : name(std::move(n)) {
+        text += ",\"";
+        appendEscaped(text, name.data(), name.size());
+        text += "\":";
+    }
+
+    std::string name;
+    std::string text;
+};
+
+/**
+ * The fragment of the key named by the Name type of a NamedItemTag, built
+ * once per name, i.e. per member of an adapted type.
+ */
+template <typename Name>
+struct key_fragment {
+    static const KeyFragment value;
+};
+
+template <typename Name>
+const KeyFragment key_fragment<Name>::value{std::string(Name::call())};
+
+/**
+ * Writes the number as yajl_gen_double does: a floating point value always
+ * has a fraction or an exponent ("14.0"), NaN and infinity are errors.
+ */
+template <typename T>
+inline char* formatNumber(char* first, T v) {
+    if (!common::numeric::isFinite(v)) {
+        throw JsonError("json::Generator error: invalid number");
+    }
+    char* last = common::formatNumber(first, v);
+    if (std::is_floating_point<T>::value
+            && std::find_if(first, last, [](char c) { return c == '.' || c == 'e'; }) == last) {
+        *last++ = '.';
+        *last++ = '0';
+    }
+    return last;
+}
+
+/**
+ * Output of the generator that counts the bytes instead of storing them.
+ */
+class ByteCounter {
+public:
+    void add(std::size_t n) { size_ += n; }
+    void append(const char*, std::size_t n) { add(n); }
+    ByteCounter& operator+=(char) { add(1); return *this; }
+    std::size_t size() const { return size_; }
+    void clear() { size_ = 0; }
+private:
+    std::size_t size_ = 0;
+};
+
+inline void appendEscaped(ByteCounter& out, const char* s, std::size_t n) {
+    out.add(escapedSize(s, n));
+}
+
+/**
+ * Appends the base64 of the data, encoded by pieces of a stack buffer.
+ */
+template <typename Output>
+inline void appendBase64(Output& out, const unsigned char* s, std::size_t n) {
+    char buf[4096];
+    const std::size_t piece = sizeof(buf) / 4 * 3;
+    while (n) {
+        const std::size_t k = std::min(n, piece);
+        out.append(buf, common::base64::encode(s, k, buf) - buf);
+        s += k;
+        n -= k;
+    }
+}
+
+inline void appendBase64(ByteCounter& out, const unsigned char*, std::size_t n) {
+    out.add(common::base64::encodedSize(n));
+}
+
+/**
+ * Native JSON generator, a replacement of yajl_gen without beautify: the
+ * same state machine and separators, so with the numbers of formatNumber on
+ * both sides the output is byte identical. Tokens are appended straight into
+ * the Output (a std::string, Rope or ByteCounter), misuse is reported by
+ * JsonError.
+ */
+template <typename Output>
+class BasicGenerator {
+public:
+    enum { maxDepth = 128 };
+
+    explicit BasicGenerator(Output out = Output()) : out_(std::move(out)) {
+        states_.reserve(16);
+        states_.push_back(start);
+    }
+
+    void mapOpen() {
+        openContainer(mapStart);
+        out_ += '{';
+    }
+
+    void mapClose() {
+        closeContainer(mapStart, mapKey);
+        out_ += '}';
+    }
+
+    void arrayOpen() {
+        openContainer(arrayStart);
+        out_ += '[';
+    }
+
+    void arrayClose() {
+        closeContainer(arrayStart, inArray);
+        out_ += ']';
+    }
+
+    void string(const char* s, std::size_t n) {
+        ensureValidState();
+        insertSeparator();
+        out_ += '"';
+        appendEscaped(out_, s, n);
+        out_ += '"';
+        appendedAtom();
+    }
+
+    void string(const std::string& s) {
+        string(s.data(), s.size());
+    }
+
+    /**
+     * Writes the data as a base64 string, it never needs escaping.
+     */
+    void base64(const unsigned char* data, std::size_t size) {
+        ensureValidState();
+        insertSeparator();
+        out_ += '"';
+        appendBase64(out_, data, size);
+        out_ += '"';
+        appendedAtom();
+    }
+
+    /**
+     * Writes the precomputed key, the comma is dropped for the first one.
+     */
+    void key(const KeyFragment& k) {
+        if (state() == mapStart) {
+            out_.append(k.text.data() + 1, k.text.size() - 1);
+        } else if (state() == mapKey) {
+            out_.append(k.text.data(), k.text.size());
+        } else {
+            throw JsonError("json::Generator error: unexpected key");
+        }
+        state() = mapColon;
+    }
+
+    template <typename T>
+    void number(T v) {
+        char buf[common::numeric::bufferSize];
+        const char* const last = formatNumber(buf, v);
+        beginValue();
+        out_.append(buf, last - buf);
+        appendedAtom();
+    }
+
+    /**
+     * Writes the array of numbers in one go: the items are formatted into a
+     * stack buffer with the separators and appended by large pieces.
+     */
+    template <typename T>
+    void numberArray(const T* data, std::size_t size) {
+        arrayOpen();
+        char buf[4096];
+        char* const end = buf + sizeof(buf) - common::numeric::bufferSize - 1;
+        char* p = buf;
+        for (std::size_t i = 0; i != size; ++i) {
+            if (p > end) {
+                out_.append(buf, p - buf);
+                p = buf;
+            }
+            *p = ',';
+            p += i != 0;
+            p = formatNumber(p, data[i]);
+        }
+        out_.append(buf, p - buf);
+        if (size) {
+            state() = inArray;
+        }
+        arrayClose();
+    }
+
+    void boolean(bool v) {
+        beginValue();
+        if (v) {
+            out_.append("true", 4);
+        } else {
+            out_.append("false", 5);
+        }
+        appendedAtom();
+    }
+
+    void null() {
+        beginValue();
+        out_.append("null", 4);
+        appendedAtom();
+    }
+
+    const Output& buffer() const { return out_; }
+
+    void reserve(std::size_t n) { out_.reserve(n); }
+
+    /**
+     * Moves the generated text out, the generator keeps the state.
+     */
+    Output release() {
+        Output retval;
+        std::swap(retval, out_);
+        return retval;
+    }
+
+    /**
+     * Drops the generated text but keeps the state, the same as
+     * yajl_gen_clear does, so the output can be taken by chunks.
+     */
+    void clear() { out_.clear(); }
+
+private:
+    // mapColon is mapValue with the colon already written by key()
+    enum State : unsigned char { start, mapStart, mapKey, mapValue, mapColon, arrayStart, inArray, complete };
+
+    State& state() { return states_.back(); }
+
+    void ensureValidState() {
+        if (state() == complete) {
+            throw JsonError("json::Generator error: generation complete");
+        }
+    }
+
+    void beginValue() {
+        ensureValidState();
+        if (state() == mapStart || state() == mapKey) {
+            throw JsonError("json::Generator error: keys must be strings");
+        }
+        insertSeparator();
+    }
+
+    void insertSeparator() {
+        if (state() == mapKey || state() == inArray) {
+            out_ += ',';
+        } else if (state() == mapValue) {
+            out_ += ':';
+        }
+    }
+
+    void appendedAtom() {
+        switch (state()) {
+            case start: state() = complete; break;
+            case mapStart:
+            case mapKey: state() = mapValue; break;
+            case arrayStart: state() = inArray; break;
+            case mapValue:
+            case mapColon: state() = mapKey; break;
+            default: break;
+        }
+    }
+
+    void openContainer(State s) {
+        beginValue();
+        if (states_.size() >= maxDepth) {
+            throw JsonError("json::Generator error: max depth exceeded");
+        }
+        states_.push_back(s);
+    }
+
+    void closeContainer(State empty, State nonEmpty) {
+        if (states_.size() < 2 || (state() != empty && state() != nonEmpty)) {
+            throw JsonError("json::Generator error: unexpected end of container");
+        }
+        states_.pop_back();
+        appendedAtom();
+    }
+
+    Output out_;
+    std::vector<State> states_;
+};
+
+using Generator = BasicGenerator<std::string>;
+
+/**
+ * Computes the exact size of the text without generating it.
+ */
+using SizeCounter = BasicGenerator<ByteCounter>;
+
+using RopeGenerator = BasicGenerator<Rope>;
+
+using Handle = boost::shared_ptr<Generator>;
+
+inline Handle createGenerator() {
+    return boost::make_shared<Generator>();
+}
+
+/**
+ * The text generated so far, keeps the generator alive.
+ */
+class Buffer {
+    Handle h;
+public:
+    using const_iterator = const char*;
+    using iterator = const_iterator;
+    Buffer(Handle hh) : h(std::move(hh)) {
+    }
+    const_iterator begin() const noexcept { return h->buffer().data(); }
+    const_iterator end() const noexcept { return begin() + size(); }
+    std::size_t size() const noexcept { return h->buffer().size(); }
+    std::string str() const { return h->buffer(); }
+    std::string release() { return h->release(); }
+    operator const char* () const noexcept { return begin(); }
+    operator std::string () const { return str(); }
+    bool operator !() const noexcept { return !h; }
+};
+
+} // namespace json
+
+}}}
+
+#endif // __JSON_GENERATOR_H__
@@ -0,0 +1,223 @@
+#ifndef __JSON_ROPE_H__
+#define __JSON_ROPE_H__
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <yamail/data/serialization/json_escape.h>
+
+namespace yamail { namespace data { namespace serialization { namespace json {
+
+/**
+ * Free list of the fixed size blocks of Rope. The blocks are returned to the
+ * pool when a rope is cleared or destroyed, at most maxFree of them are kept.
+ */
+class BlockPool {
+public:
+    enum : std::size_t { blockSize = 16 * 1024, maxFree = 256 };
+
+    using Block = std::unique_ptr<char[]>;
+
+    Block get() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_.empty()) {
+                Block retval = std::move(free_.back());
+                free_.pop_back();
+                return retval;
+            }
+        }
+        return Block(new char[blockSize]);
+    }
+
+    void put(Block block) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.size() < maxFree) {
+            free_.push_back(std::move(block));
+        }
+    }
+
+    std::size_t freeBlocks() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return free_.size();
+    }
+
+    static BlockPool& global() {
+        static BlockPool pool;
+        return pool;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<Block> free_;
+};
+
+/**
+ * Output of the generator made of pooled fixed size blocks, so the text is
+ * never reallocated or flattened. The segments are exposed as a sequence of
+ * buffers for a gather write, e.g. buffers<boost::asio::const_buffer>().
+ *
+ * With a non zero reference threshold the strings of at least that size
+ * with nothing to escape are not copied: the segment points to the memory of
+ * the string itself, which must outlive the rope.
+ */
+class Rope {
+public:
+    struct Segment {
+        const char* data;
+        std::size_t size;
+    };
+
+    explicit Rope(BlockPool& pool = BlockPool::global()) : pool_(&pool) {
+    }
+
+    Rope(const Rope&) = delete;
+    Rope& operator=(const Rope&) = delete;
+
+    Rope(Rope&& other) noexcept
+    : pool_(other.pool_), blocks_(std::move(other.blocks_)), segments_(std::move(other.segments_)),
+      pos_(other.pos_), end_(other.end_), size_(other.size_), referenceThreshold_(other.referenceThreshold_) {
+        other.reset();
+    }
+
+    Rope& operator=(Rope&& other) noexcept {
+        if (this != &other) {
+            clear();
+            pool_ = other.pool_;
+            blocks_ = std::move(other.blocks_);
+            segments_ = std::move(other.segments_);
+            pos_ = other.pos_;
+            end_ = other.end_;
+            size_ = other.size_;
+            referenceThreshold_ = other.referenceThreshold_;
+            other.reset();
+        }
+        return *this;
+    }
+
+    ~Rope() {
+        clear();
+    }
+
+    void append(const char* s, std::size_t n) {
+        while (n) {
+            if (pos_ == end_) {
+                addBlock();
+            }
+            const std::size_t k = std::min<std::size_t>(n, end_ - pos_);
+            std::memcpy(pos_, s, k);
+            extend(k);
+            s += k;
+            n -= k;
+        }
+    }
+
+    Rope& operator+=(char c) {
+        if (pos_ == end_) {
+            addBlock();
+        }
+        *pos_ = c;
+        extend(1);
+        return *this;
+    }
+
+    /**
+     * Adds a segment pointing to the external memory instead of a copy.
+     */
+    void appendReference(const char* s, std::size_t n) {
+        if (n) {
+            segments_.push_back(Segment{s, n});
+            size_ += n;
+        }
+    }
+
+    std::size_t referenceThreshold() const { return referenceThreshold_; }
+    void referenceStrings(std::size_t threshold) { referenceThreshold_ = threshold; }
+
+    /**
+     * The blocks are never reallocated, nothing to reserve.
+     */
+    void reserve(std::size_t) {}
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    const std::vector<Segment>& segments() const { return segments_; }
+
+    template <typename ConstBuffer>
+    std::vector<ConstBuffer> buffers() const {
+        std::vector<ConstBuffer> retval;
+        retval.reserve(segments_.size());
+        for (const auto& s : segments_) {
+            retval.emplace_back(s.data, s.size);
+        }
+        return retval;
+    }
+
+    std::string str() const {
+        std::string retval;
+        retval.reserve(size_);
+        for (const auto& s : segments_) {
+            retval.append(s.data, s.size);
+        }
+        return retval;
+    }
+
+    void clear() {
+        for (auto& b : blocks_) {
+            pool_->put(std::move(b));
+        }
+        blocks_.clear();
+        segments_.clear();
+        pos_ = end_ = nullptr;
+        size_ = 0;
+    }
+
+private:
+    void addBlock() {
+        blocks_.push_back(pool_->get());
+        pos_ = blocks_.back().get();
+        end_ = pos_ + BlockPool::blockSize;
+    }
+
+    void extend(std::size_t n) {
+        if (segments_.empty() || segments_.back().data + segments_.back().size != pos_) {
+            segments_.push_back(Segment{pos_, 0});
+        }
+        segments_.back().size += n;
+        pos_ += n;
+        size_ += n;
+    }
+
+    void reset() {
+        blocks_.clear();
+        segments_.clear();
+        pos_ = end_ = nullptr;
+        size_ = 0;
+    }
+
+    BlockPool* pool_;
+    std::vector<BlockPool::Block> blocks_;
+    std::vector<Segment> segments_;
+    char* pos_ = nullptr;
+    char* end_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t referenceThreshold_ = 0;
+};
+
+inline void appendEscaped(Rope& out, const char* s, std::size_t n) {
+    const std::size_t threshold = out.referenceThreshold();
+    if (threshold && n >= threshold && escape::find(s, s + n) == s + n) {
+        out.appendReference(s, n);
+    } else {
+        appendEscaped<Rope>(out, s, n);
+    }
+}
+
+}}}}
+
+#endif // __JSON_ROPE_H__
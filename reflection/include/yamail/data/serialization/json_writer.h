@@ -2,17 +2,13 @@
 #define __JSON_WRITER_H__
 
 #include <yamail/data/reflection/reflection.h>
+#include <yamail/data/serialization/json_generator.h>
 #include <yajl/yajl_gen.h>
 
 namespace yamail { namespace data { namespace serialization {
 
 using namespace yamail::data::reflection;
 
-class JsonError : public std::runtime_error {
-public:
-    JsonError(const std::string& msg) : std::runtime_error(msg) {}
-};
-
 namespace yajl {
 
 using Handle = boost::shared_ptr<yajl_gen_t>;
@@ -52,76 +48,112 @@ public:
     bool operator !() const noexcept { return buf == nullptr; }
 };
 
-class Writer : public Visitor {
+/**
+ * yajl_gen behind the interface of json::Generator.
+ */
+class Generator {
 public:
-    explicit Writer (Handle gen) : gen(gen) {
+    explicit Generator (const Handle& h) : gen(h.get()) {
+    }
+
+    void mapOpen() { checkError( yajl_gen_map_open(gen) ); }
+    void mapClose() { checkError( yajl_gen_map_close(gen) ); }
+    void arrayOpen() { checkError( yajl_gen_array_open(gen) ); }
+    void arrayClose() { checkError( yajl_gen_array_close(gen) ); }
+    void boolean(bool v) { checkError( yajl_gen_bool(gen, v) ); }
+    void null() { checkError( yajl_gen_null(gen) ); }
+
+    /**
+     * The text of json::formatNumber is passed as is, so both generators
+     * write the same numbers.
+     */
+    template <typename T>
+    void number(T v) {
+        char buf[common::numeric::bufferSize];
+        const char* const last = json::formatNumber(buf, v);
+        checkError( yajl_gen_number(gen, buf, last - buf) );
+    }
+
+    template <typename T>
+    void numberArray(const T* data, std::size_t size) {
+        arrayOpen();
+        for (std::size_t i = 0; i != size; ++i) {
+            number(data[i]);
+        }
+        arrayClose();
     }
 
-    template<typename T, typename Tag>
-    void apply(const T& value, Tag rootName) {
-        checkError ( yajl_gen_map_open(gen.get()) );
-        applyVisitor(value, *this, rootName);
-        checkError ( yajl_gen_map_close(gen.get()) );
+    void string(const char* s, std::size_t n) {
+        checkError( yajl_gen_string(gen, reinterpret_cast<const unsigned char*>(s), n) );
     }
 
-    template<typename T>
-    void apply(const T & value) {
-        applyVisitor(value, *this, SequenceItemTag());
+    void string(const std::string& s) {
+        string(s.data(), s.size());
     }
 
-    template <typename Tag>
-    void onValue(float f, Tag tag) {
-        onValue(static_cast<const double>(f), tag);
+    void key(const json::KeyFragment& k) {
+        string(k.name);
     }
 
-    template<typename ... Args>
-    void onValue(double d, NamedItemTag<Args...> tag) {
-        addString(name(tag));
-        onValue(d, SequenceItemTag{});
+    void base64(const unsigned char* data, std::size_t size) {
+        string(common::base64::encode(data, size));
     }
 
-    void onValue(double d, SequenceItemTag) {
-        checkError(yajl_gen_double(gen.get(), d));
-    }
+private:
+    yajl_gen gen;
+};
 
-    template <typename Tag>
-    void onValue(int i, Tag tag) {
-        onValue(static_cast<const long>(i), tag);
+} // namespace yajl
+
+/**
+ * The writer borrows the generator - json::Generator or yajl::Generator -
+ * from its owner. Nested items are written by the same writer, so no copies
+ * are made on the way.
+ */
+template <typename Generator>
+class BasicWriter : public Visitor {
+public:
+    explicit BasicWriter (Generator& gen) : gen(gen) {
     }
 
-    template <typename ... Args>
-    void onValue(long l, NamedItemTag<Args...> tag) {
-        addString(name(tag));
-        onValue(l, SequenceItemTag{});
+    template<typename T, typename Tag>
+    void apply(const T& value, Tag rootName) {
+        gen.mapOpen();
+        applyVisitor(value, *this, rootName);
+        gen.mapClose();
     }
 
-    void onValue(long l, SequenceItemTag) {
-        checkError( yajl_gen_integer(gen.get(), l) );
+    template<typename T>
+    void apply(const T & value) {
+        applyVisitor(value, *this, SequenceItemTag());
     }
 
-    template<typename ... Args>
-    void onValue(std::size_t s, NamedItemTag<Args...> tag) {
-        addString(name(tag));
-        onValue(s, SequenceItemTag{});
+    template <typename Value, typename ... Args>
+    typename std::enable_if<common::numeric::is_number<Value>::value>::type
+    onValue(Value v, NamedItemTag<Args...> tag) {
+        addKey(tag);
+        onValue(v, SequenceItemTag{});
     }
 
-    void onValue(std::size_t s, SequenceItemTag) {
-        checkError( yajl_gen_integer(gen.get(), s) );
+    template <typename Value>
+    typename std::enable_if<common::numeric::is_number<Value>::value>::type
+    onValue(Value v, SequenceItemTag) {
+        gen.number(v);
     }
 
     template<typename ...Args>
     void onValue(bool b, NamedItemTag<Args...> tag) {
-        addString(name(tag));
+        addKey(tag);
         onValue(b, SequenceItemTag{});
     }
 
     void onValue(bool b, SequenceItemTag) {
-        checkError( yajl_gen_bool(gen.get(), b) );
+        gen.boolean(b);
     }
 
     template<typename ...Args>
     void onValue(const std::string & s, NamedItemTag<Args...> tag) {
-        addString(name(tag));
+        addKey(tag);
         onValue(s, SequenceItemTag{});
     }
 
@@ -130,52 +162,81 @@ public:
     }
 
     template<typename Value, typename Tag>
-    void onValue(const Value& p, Tag tag) {
+    typename std::enable_if<!common::numeric::is_number<Value>::value>::type
+    onValue(const Value& p, Tag tag) {
         onValue ( boost::lexical_cast<std::string>(p), tag);
     }
 
+    using Visitor::onArithmeticRange;
+
+    template <typename Value, typename ... Args>
+    typename std::enable_if<common::numeric::is_number<Value>::value, bool>::type
+    onArithmeticRange(const Value* data, std::size_t size, NamedItemTag<Args...> tag) {
+        addKey(tag);
+        return onArithmeticRange(data, size, SequenceItemTag{});
+    }
+
+    template <typename Value>
+    typename std::enable_if<common::numeric::is_number<Value>::value, bool>::type
+    onArithmeticRange(const Value* data, std::size_t size, SequenceItemTag) {
+        gen.numberArray(data, size);
+        return true;
+    }
+
+    template <typename Container, typename ... Args>
+    bool onBlob(const BasicBlob<Container>& blob, NamedItemTag<Args...> tag) {
+        addKey(tag);
+        return onBlob(blob, SequenceItemTag{});
+    }
+
+    template <typename Container>
+    bool onBlob(const BasicBlob<Container>& blob, SequenceItemTag) {
+        gen.base64(reinterpret_cast<const unsigned char*>(blob.data.data()), blob.data.size());
+        return true;
+    }
+
     template<typename Struct, typename ... Args>
-    Writer onStructStart(const Struct& p, NamedItemTag<Args...> tag) {
-        addString( name(tag) );
+    BasicWriter& onStructStart(const Struct& p, NamedItemTag<Args...> tag) {
+        addKey(tag);
         return onStructStart(p, SequenceItemTag{});
     }
 
     template<typename Struct>
-    Writer onStructStart(const Struct&, SequenceItemTag) {
-        checkError ( yajl_gen_map_open(gen.get()) );
+    BasicWriter& onStructStart(const Struct&, SequenceItemTag) {
+        gen.mapOpen();
         return *this;
     }
 
     template<typename Struct, typename Tag>
     void onStructEnd(const Struct&, Tag) {
-        checkError( yajl_gen_map_close(gen.get()) );
+        gen.mapClose();
     }
 
     template<typename Map, typename Tag>
-    Writer onMapStart(const Map& m, Tag tag) {
+    BasicWriter& onMapStart(const Map& m, Tag tag) {
         return onStructStart(m, tag);
     }
 
     template<typename Map, typename Tag>
     void onMapEnd(const Map&, Tag) {
-        checkError( yajl_gen_map_close(gen.get()) );
+        gen.mapClose();
     }
 
     template<typename Seq, typename ... Args>
-    Writer onSequenceStart(const Seq& seq, NamedItemTag<Args...> tag) {
-        addString( name(tag) );
+    BasicWriter& onSequenceStart(const Seq& seq, NamedItemTag<Args...> tag) {
+        addKey(tag);
         return onSequenceStart(seq, SequenceItemTag());
     }
 
     template<typename Seq>
-    Writer onSequenceStart(const Seq&, SequenceItemTag) {
-        checkError(yajl_gen_array_open(gen.get()));
+    BasicWriter& onSequenceStart(const Seq&, SequenceItemTag) {
+        gen.arrayOpen();
         return *this;
     }
 
     template<typename Seq, typename Tag>
     void onSequenceEnd(const Seq& , Tag) {
-        checkError(yajl_gen_array_close(gen.get()));
+        gen.arrayClose();
     }
 
     template <typename Ptree, typename Tag >
@@ -183,13 +244,13 @@ public:
         if (tree.size() == 0) {
             onValue(tree.data(), tag);
         } else if (tree.front().first.empty()) {
-            auto v = onSequenceStart(tree, tag);
+            auto& v = onSequenceStart(tree, tag);
             for (const auto& i : tree) {
                 applyVisitor(i.second, v, SequenceItemTag());
             }
             onSequenceEnd(tree, tag);
         } else {
-            auto v = onMapStart(tree, tag);
+            auto& v = onMapStart(tree, tag);
             for (const auto& i : tree) {
                 applyVisitor(i.second, v, namedItemTag(i.first));
             }
@@ -199,29 +260,113 @@ public:
 
 private:
     void addString ( const std::string & str ) {
-        checkError( yajl_gen_string(gen.get(),
-                    reinterpret_cast<const unsigned char*>(str.c_str()),
-                    str.size()) );
+        gen.string(str);
     }
 
-    std::string defaultValueName = "value";
-    Handle gen;
+    template <typename Name>
+    void addKey(NamedItemTag<Name>) {
+        gen.key(json::key_fragment<Name>::value);
+    }
+
+    template <typename T>
+    void addKey(const NamedItemTag<TagValue<T>>& tag) {
+        addString(name(tag));
+    }
+
+    Generator& gen;
 };
 
+namespace yajl {
+
+using Writer = BasicWriter<Generator>;
+
+template <typename T>
+inline Buffer toJson(const T& v) {
+    auto h = createGenerator();
+    Generator gen(h);
+    Writer(gen).apply(v);
+    return Buffer(h);
+}
+
+template <typename T>
+inline Buffer toJson(const T& v, const std::string& rootName) {
+    auto h = createGenerator();
+    Generator gen(h);
+    Writer(gen).apply(v, namedItemTag(rootName));
+    return Buffer(h);
+}
+
 } // namespace yajl
 
+namespace json {
+
+using Writer = BasicWriter<Generator>;
+
+} // namespace json
+
+/**
+ * Exact size of the toJson result, computed by the same writer over
+ * json::SizeCounter: a pass over the string lengths and the escapes only.
+ */
+template <typename T>
+inline std::size_t jsonSize(const T& v) {
+    json::SizeCounter counter;
+    BasicWriter<json::SizeCounter>(counter).apply(v);
+    return counter.buffer().size();
+}
+
+template <typename T>
+inline std::size_t jsonSize(const T& v, const std::string& rootName) {
+    json::SizeCounter counter;
+    BasicWriter<json::SizeCounter>(counter).apply(v, namedItemTag(rootName));
+    return counter.buffer().size();
+}
+
+template <typename T>
+inline json::Buffer toJson(const T& v) {
+    auto h = json::createGenerator();
+    h->reserve(jsonSize(v));
+    json::Writer(*h).apply(v);
+    return json::Buffer(h);
+}
+
+template <typename T>
+inline json::Buffer toJson(const T& v, const std::string& rootName) {
+    auto h = json::createGenerator();
+    h->reserve(jsonSize(v, rootName));
+    json::Writer(*h).apply(v, namedItemTag(rootName));
+    return json::Buffer(h);
+}
+
+/**
+ * Writes the value into pooled blocks instead of one contiguous buffer, the
+ * result is sent by a gather write of Rope::buffers().
+ */
+template <typename T>
+inline json::Rope toJsonRope(const T& v) {
+    json::RopeGenerator gen;
+    BasicWriter<json::RopeGenerator>(gen).apply(v);
+    return gen.release();
+}
+
 template <typename T>
-inline yajl::Buffer toJson(const T& v) {
-    auto h = yajl::createGenerator();
-    yajl::Writer(h).apply(v);
-    return yajl::Buffer(h);
+inline json::Rope toJsonRope(const T& v, const std::string& rootName) {
+    json::RopeGenerator gen;
+    BasicWriter<json::RopeGenerator>(gen).apply(v, namedItemTag(rootName));
+    return gen.release();
 }
 
+/**
+ * The same with the strings of at least referenceThreshold bytes with
+ * nothing to escape referenced by the rope, v must outlive the result.
+ */
 template <typename T>
-inline yajl::Buffer toJson(const T& v, const std::string& rootName) {
-    auto h = yajl::createGenerator();
-    yajl::Writer(h).apply(v, namedItemTag(rootName));
-    return yajl::Buffer(h);
+inline json::Rope toJsonRope(const T& v, const std::string& rootName, std::size_t referenceThreshold) {
+    json::Rope rope;
+    rope.referenceStrings(referenceThreshold);
+    json::RopeGenerator gen(std::move(rope));
+    BasicWriter<json::RopeGenerator>(gen).apply(v, namedItemTag(rootName));
+    return gen.release();
 }
 
 template <typename T, typename Tag = SequenceItemTag>
@@ -232,46 +377,40 @@ struct JsonChunks {
     JsonChunks(const JsonChunks& other) = default;
     JsonChunks(JsonChunks&& other) = default;
 
-    yajl::Handle handle_;
+    json::Handle handle_;
     Tag tag;
     bool firstCall = true;
 
-    yajl::Handle handle() {
+    json::Handle handle() {
         if(handle_ == nullptr) {
-             handle_ = yajl::createGenerator();
+             handle_ = json::createGenerator();
         }
         return handle_;
     }
     template<typename Tg>
     void onStart(Tg tg) {
-        yajl::checkError( yajl_gen_map_open(handle().get()) );
-        yajl::checkError(
-            yajl_gen_string(
-                handle().get(),
-                reinterpret_cast<const unsigned char*>(name(tg).c_str()),
-                name(tg).size()
-            )
-        );
+        handle()->mapOpen();
+        handle()->string(name(tg));
         onStart(SequenceItemTag{});
     }
 
     void onStart(SequenceItemTag) {
-        yajl::checkError( yajl_gen_array_open(handle().get()) );
+        handle()->arrayOpen();
     }
 
     template<typename Tg>
     void onEnd(Tg) {
         onEnd(SequenceItemTag{});
-        yajl::checkError( yajl_gen_map_close(handle().get()) );
+        handle()->mapClose();
     }
 
     void onEnd(SequenceItemTag) {
-        yajl::checkError( yajl_gen_array_close(handle().get()) );
+        handle()->arrayClose();
     }
 
-    yajl::Buffer operator()(const boost::optional<T>& v) {
-        yajl_gen_clear(handle().get());
-        auto writer = yajl::Writer(handle());
+    json::Buffer operator()(const boost::optional<T>& v) {
+        handle()->clear();
+        auto writer = json::Writer(*handle());
 
         if( firstCall ) {
             onStart(tag);
@@ -284,7 +423,7 @@ struct JsonChunks {
             onEnd(tag);
         }
 
-        return yajl::Buffer(handle());
+        return json::Buffer(handle());
     }
 };
 
@@ -0,0 +1,509 @@
+#ifndef __PROTOBUF_WRITER_H__
+#define __PROTOBUF_WRITER_H__
+
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/optional.hpp>
+#include <boost/utility/string_ref.hpp>
+
+#include <yamail/data/reflection/reflection.h>
+#include <yamail/data/reflection/protobuf_fields.h>
+#include <yamail/data/common/protobuf.h>
+
+namespace yamail { namespace data { namespace serialization {
+
+using namespace yamail::data::reflection;
+
+class ProtobufError : public std::runtime_error {
+public:
+    ProtobufError(const std::string& msg) : std::runtime_error(msg) {}
+};
+
+namespace protobuf {
+
+using namespace common::protobuf;
+
+struct RootNodeTag {};
+
+/**
+ * The value is the field with the number of the root message.
+ */
+struct FieldNumberTag {
+    std::uint32_t number;
+};
+
+/**
+ * The first pass: counts the bytes and records the size of every nested
+ * message in the order the messages are opened, so the second pass writes
+ * the length of a message before its fields.
+ */
+class SizeCounter {
+public:
+    void varint(std::uint64_t v) { size_ += varintSize(v); }
+    void key(std::uint32_t field, WireType type) { varint(makeKey(field, type)); }
+    void fixed32(std::uint32_t) { size_ += 4; }
+    void fixed64(std::uint64_t) { size_ += 8; }
+
+    void bytes(const char*, std::size_t n) {
+        varint(n);
+        size_ += n;
+    }
+
+    void messageOpen(std::uint32_t field) {
+        key(field, lengthDelimitedType);
+        open_.emplace_back(sizes_.size(), size_);
+        sizes_.push_back(0);
+    }
+
+    void messageClose() {
+        const auto open = open_.back();
+        open_.pop_back();
+        const std::size_t n = size_ - open.second;
+        sizes_[open.first] = n;
+        size_ += varintSize(n);
+    }
+
+    std::size_t size() const { return size_; }
+    const std::vector<std::size_t>& sizes() const { return sizes_; }
+
+    void clear() {
+        size_ = 0;
+        sizes_.clear();
+        open_.clear();
+    }
+
+private:
+    std::size_t size_ = 0;
+    std::vector<std::size_t> sizes_;
+    std::vector<std::pair<std::size_t, std::size_t>> open_;
+};
+
+/**
+ * The second pass: appends the fields to the Output, the lengths of the
+ * nested messages are taken from the sizes of the first pass.
+ */
+template <typename Output>
+class BasicGenerator {
+public:
+    BasicGenerator(Output& out, const std::vector<std::size_t>& sizes) : out(out), sizes(sizes) {
+    }
+
+    void varint(std::uint64_t v) {
+        char buf[maxVarintSize];
+        out.append(buf, writeVarint(buf, v) - buf);
+    }
+
+    void key(std::uint32_t field, WireType type) { varint(makeKey(field, type)); }
+    void fixed32(std::uint32_t v) { fixed(v, 4); }
+    void fixed64(std::uint64_t v) { fixed(v, 8); }
+
+    void bytes(const char* s, std::size_t n) {
+        varint(n);
+        out.append(s, n);
+    }
+
+    void messageOpen(std::uint32_t field) {
+        key(field, lengthDelimitedType);
+        varint(sizes[next++]);
+    }
+
+    void messageClose() {}
+
+private:
+    void fixed(std::uint64_t v, std::size_t size) {
+        char buf[8];
+        for (std::size_t i = 0; i != size; ++i, v >>= 8) {
+            buf[i] = static_cast<char>(v & 0xff);
+        }
+        out.append(buf, size);
+    }
+
+    Output& out;
+    const std::vector<std::size_t>& sizes;
+    std::size_t next = 0;
+};
+
+using Generator = BasicGenerator<std::string>;
+
+template <typename T>
+inline std::uint64_t varintValue(T v) {
+    using Wide = typename std::conditional<std::is_signed<T>::value, std::int64_t, std::uint64_t>::type;
+    return static_cast<std::uint64_t>(static_cast<Wide>(v));
+}
+
+inline std::uint32_t fixedValue(float v) {
+    std::uint32_t retval;
+    std::memcpy(&retval, &v, sizeof(retval));
+    return retval;
+}
+
+inline std::uint64_t fixedValue(double v) {
+    std::uint64_t retval;
+    std::memcpy(&retval, &v, sizeof(retval));
+    return retval;
+}
+
+/**
+ * Writes the wire format of proto2 from an adapted type with the field
+ * numbers of YR_PROTOBUF_FIELDS:
+ *  - integers, chars and bool are varints (int32/int64/uint32/uint64, not sint),
+ *    float and double are fixed32 and fixed64, strings are length delimited;
+ *  - structs are nested messages, sequences are repeated fields, the
+ *    arithmetic ranges are packed;
+ *  - a map is the repeated entry message with the key 1 and the value 2,
+ *    a tuple or a pair is a message with the fields 1, 2, ...;
+ *  - absent optionals and null pointers are not written.
+ */
+template <typename Generator>
+class BasicWriter : public Visitor {
+public:
+    explicit BasicWriter(Generator& gen, std::uint32_t field = 0, bool tuple = false)
+    : gen(gen), field_(field), tuple_(tuple) {
+    }
+
+    template <typename T>
+    void apply(const T& value) {
+        applyVisitor(value, *this, RootNodeTag());
+    }
+
+    template <typename T>
+    void apply(const T& value, std::uint32_t fieldNumber) {
+        applyVisitor(value, *this, FieldNumberTag{fieldNumber});
+    }
+
+    template <typename Value, typename Tag>
+    void onValue(const Value& v, Tag tag) {
+        writeField(number(tag), v);
+    }
+
+    template <typename Value, typename K>
+    void onValue(const Value& v, NamedItemTag<TagValue<K>> tag) {
+        entryOpen(tag);
+        writeField(2, v);
+        gen.messageClose();
+    }
+
+    using Visitor::onArithmeticRange;
+
+    template <typename Value, typename Tag>
+    typename std::enable_if<std::is_arithmetic<Value>::value, bool>::type
+    onArithmeticRange(const Value* data, std::size_t size, Tag tag) {
+        checkRepeated(tag);
+        const auto field = number(tag);
+        if (size) {
+            std::size_t payload = 0;
+            for (std::size_t i = 0; i != size; ++i) {
+                payload += packedSize(data[i]);
+            }
+            gen.key(field, lengthDelimitedType);
+            gen.varint(payload);
+            for (std::size_t i = 0; i != size; ++i) {
+                writeValue(data[i]);
+            }
+        }
+        return true;
+    }
+
+    template <typename Container, typename Tag>
+    bool onBlob(const BasicBlob<Container>& blob, Tag tag) {
+        gen.key(number(tag), lengthDelimitedType);
+        gen.bytes(reinterpret_cast<const char*>(blob.data.data()), blob.data.size());
+        return true;
+    }
+
+    template <typename Container, typename K>
+    bool onBlob(const BasicBlob<Container>& blob, NamedItemTag<TagValue<K>> tag) {
+        entryOpen(tag);
+        onBlob(blob, FieldNumberTag{2});
+        gen.messageClose();
+        return true;
+    }
+
+    template <typename Optional, typename Tag>
+    bool onOptional(const Optional& p, Tag) {
+        return p.is_initialized();
+    }
+
+    template <typename Optional>
+    bool onOptional(const Optional& p, SequenceItemTag) {
+        skipTupleField(p.is_initialized());
+        return p.is_initialized();
+    }
+
+    template <typename Pointer, typename Tag>
+    bool onSmartPointer(const Pointer& p, Tag) {
+        return p.get();
+    }
+
+    template <typename Pointer>
+    bool onSmartPointer(const Pointer& p, SequenceItemTag) {
+        skipTupleField(p.get());
+        return p.get();
+    }
+
+    template <typename Struct>
+    BasicWriter& onStructStart(const Struct&, RootNodeTag) {
+        return *this;
+    }
+
+    template <typename Struct, typename Tag>
+    BasicWriter& onStructStart(const Struct&, Tag tag) {
+        gen.messageOpen(number(tag));
+        return *this;
+    }
+
+    template <typename Struct, typename K>
+    BasicWriter& onStructStart(const Struct&, NamedItemTag<TagValue<K>> tag) {
+        entryOpen(tag);
+        gen.messageOpen(2);
+        return *this;
+    }
+
+    template <typename Struct>
+    void onStructEnd(const Struct&, RootNodeTag) {
+    }
+
+    template <typename Struct, typename Tag>
+    void onStructEnd(const Struct&, Tag) {
+        gen.messageClose();
+    }
+
+    template <typename Struct, typename K>
+    void onStructEnd(const Struct&, NamedItemTag<TagValue<K>>) {
+        gen.messageClose();
+        gen.messageClose();
+    }
+
+    template <typename Map, typename Tag>
+    BasicWriter onMapStart(const Map&, Tag tag) {
+        checkRepeated(tag);
+        return BasicWriter(gen, number(tag));
+    }
+
+    template <typename Map, typename Tag>
+    void onMapEnd(const Map&, Tag) {
+    }
+
+    template <typename Seq, typename Tag>
+    typename std::enable_if<!is_tuple<Seq>::value, BasicWriter>::type
+    onSequenceStart(const Seq&, Tag tag) {
+        checkRepeated(tag);
+        return BasicWriter(gen, number(tag));
+    }
+
+    template <typename Seq, typename Tag>
+    typename std::enable_if<is_tuple<Seq>::value, BasicWriter>::type
+    onSequenceStart(const Seq&, Tag tag) {
+        gen.messageOpen(number(tag));
+        return BasicWriter(gen, 0, true);
+    }
+
+    template <typename Seq, typename Tag>
+    void onSequenceEnd(const Seq&, Tag) {
+        if (is_tuple<Seq>::value) {
+            gen.messageClose();
+        }
+    }
+
+private:
+    template <typename Name>
+    static std::uint32_t number(NamedItemTag<Name>) {
+        return members::protobuf_field_number<Name>::value;
+    }
+
+    static std::uint32_t number(FieldNumberTag tag) {
+        return tag.number;
+    }
+
+    std::uint32_t number(SequenceItemTag) {
+        return tuple_ ? ++field_ : field_;
+    }
+
+    template <typename Tag>
+    void checkRepeated(Tag) const {
+    }
+
+    void checkRepeated(SequenceItemTag) const {
+        if (!tuple_) {
+            throw ProtobufError("protobuf::Writer error: a repeated field of repeated fields");
+        }
+    }
+
+    void skipTupleField(bool present) {
+        if (tuple_ && !present) {
+            ++field_;
+        }
+    }
+
+    template <typename K>
+    void entryOpen(const NamedItemTag<TagValue<K>>& tag) {
+        gen.messageOpen(field_);
+        writeField(1, name(tag));
+    }
+
+    template <typename Value>
+    typename std::enable_if<std::is_integral<Value>::value && !std::is_same<Value, bool>::value>::type
+    writeField(std::uint32_t field, Value v) {
+        gen.key(field, varintType);
+        writeValue(v);
+    }
+
+    void writeField(std::uint32_t field, float v) {
+        gen.key(field, fixed32Type);
+        writeValue(v);
+    }
+
+    void writeField(std::uint32_t field, double v) {
+        gen.key(field, fixed64Type);
+        writeValue(v);
+    }
+
+    void writeField(std::uint32_t field, long double v) {
+        writeField(field, static_cast<double>(v));
+    }
+
+    void writeField(std::uint32_t field, bool v) {
+        gen.key(field, varintType);
+        gen.varint(v);
+    }
+
+    void writeField(std::uint32_t field, const std::string& v) {
+        gen.key(field, lengthDelimitedType);
+        gen.bytes(v.data(), v.size());
+    }
+
+    template <typename Value>
+    typename std::enable_if<!std::is_arithmetic<Value>::value>::type
+    writeField(std::uint32_t field, const Value& v) {
+        writeField(field, boost::lexical_cast<std::string>(v));
+    }
+
+    template <typename Value>
+    typename std::enable_if<std::is_integral<Value>::value>::type
+    writeValue(Value v) {
+        gen.varint(varintValue(v));
+    }
+
+    void writeValue(float v) { gen.fixed32(fixedValue(v)); }
+    void writeValue(double v) { gen.fixed64(fixedValue(v)); }
+    void writeValue(long double v) { writeValue(static_cast<double>(v)); }
+
+    template <typename Value>
+    static typename std::enable_if<std::is_integral<Value>::value, std::size_t>::type
+    packedSize(Value v) {
+        return varintSize(varintValue(v));
+    }
+
+    static std::size_t packedSize(float) { return 4; }
+    static std::size_t packedSize(double) { return 8; }
+    static std::size_t packedSize(long double) { return 8; }
+
+    Generator& gen;
+    std::uint32_t field_;
+    bool tuple_;
+};
+
+using Writer = BasicWriter<Generator>;
+
+/**
+ * Sizes of the value and of its nested messages, the first pass of
+ * toProtobuf.
+ */
+template <typename T, typename ... Field>
+inline SizeCounter countSizes(const T& v, Field ... fieldNumber) {
+    SizeCounter retval;
+    BasicWriter<SizeCounter>(retval).apply(v, fieldNumber...);
+    return retval;
+}
+
+} // namespace protobuf
+
+/**
+ * Writes the adapted struct as a protobuf message.
+ */
+template <typename T>
+inline std::string toProtobuf(const T& v) {
+    const auto sizes = protobuf::countSizes(v);
+    std::string retval;
+    retval.reserve(sizes.size());
+    protobuf::Generator gen(retval, sizes.sizes());
+    protobuf::Writer(gen).apply(v);
+    return retval;
+}
+
+/**
+ * Writes the value as the field with the given number of a message, e.g. a
+ * sequence as a repeated field of the root message.
+ */
+template <typename T>
+inline std::string toProtobuf(const T& v, std::uint32_t fieldNumber) {
+    const auto sizes = protobuf::countSizes(v, fieldNumber);
+    std::string retval;
+    retval.reserve(sizes.size());
+    protobuf::Generator gen(retval, sizes.sizes());
+    protobuf::Writer(gen).apply(v, fieldNumber);
+    return retval;
+}
+
+/**
+ * Appends the message as a length delimited record: the varint of its size
+ * and the message itself, as writeDelimitedTo of the protobuf library does.
+ * The sizes are kept to be reused by the next record.
+ */
+template <typename T>
+inline void appendDelimitedProtobuf(std::string& out, const T& v, protobuf::SizeCounter& sizes) {
+    sizes.clear();
+    protobuf::BasicWriter<protobuf::SizeCounter>(sizes).apply(v);
+    out.reserve(out.size() + protobuf::maxVarintSize + sizes.size());
+    char buf[protobuf::maxVarintSize];
+    out.append(buf, protobuf::writeVarint(buf, sizes.size()) - buf);
+    protobuf::Generator gen(out, sizes.sizes());
+    protobuf::Writer(gen).apply(v);
+}
+
+/**
+ * The chunks of a stream of length delimited records, one record per item.
+ * A chunk refers to the buffer of the object, so it is valid until the
+ * next call; the end of the stream is the empty chunk. Like the handle of
+ * JsonChunks the buffer is created by the first call and shared by the
+ * copies of the object, the continuations carry them along.
+ */
+template <typename T>
+struct ProtobufChunks {
+    struct State {
+        std::string buffer;
+        protobuf::SizeCounter sizes;
+    };
+
+    std::shared_ptr<State> state_;
+
+    State& state() {
+        if (state_ == nullptr) {
+            state_ = std::make_shared<State>();
+        }
+        return *state_;
+    }
+
+    boost::string_ref operator()(const boost::optional<T>& v) {
+        State& s = state();
+        s.buffer.clear();
+        if (v) {
+            appendDelimitedProtobuf(s.buffer, *v, s.sizes);
+        }
+        return s.buffer;
+    }
+};
+
+template <typename T>
+ProtobufChunks<T> toChunkedProtobuf() {
+    return ProtobufChunks<T>();
+}
+
+}}}
+
+#endif // __PROTOBUF_WRITER_H__
@@ -2,6 +2,8 @@
 #define __PTREE_WRITER_H_
 
 #include <yamail/data/reflection/reflection.h>
+#include <yamail/data/common/base64.h>
+#include <yamail/data/common/numeric_format.h>
 #include <stack>
 #include <boost/property_tree/ptree.hpp>
 
@@ -25,13 +27,29 @@ public:
     }
 
     template<typename P, typename ... Args>
-    void onValue(const P & p, NamedItemTag<Args...> tag) {
+    typename std::enable_if<!common::numeric::is_number<P>::value>::type
+    onValue(const P & p, NamedItemTag<Args...> tag) {
         level().add(name(tag), p);
     }
 
+    template<typename P, typename ... Args>
+    typename std::enable_if<common::numeric::is_number<P>::value>::type
+    onValue(P p, NamedItemTag<Args...> tag) {
+        char buf[common::numeric::bufferSize];
+        const char* const last = common::formatNumber(buf, p);
+        level().add(name(tag), std::string(static_cast<const char*>(buf), last));
+    }
+
     template<typename P>
     void onValue(const P & p, SequenceItemTag) {
-        onValue(p, namedItemTag(defaultValueName));
+        onValue(p, namedItemTag(defaultValueName()));
+    }
+
+    template <typename Container, typename Tag>
+    bool onBlob(const BasicBlob<Container>& blob, Tag tag) {
+        onValue(common::base64::encode(reinterpret_cast<const unsigned char*>(blob.data.data()),
+                blob.data.size()), tag);
+        return true;
     }
 
     template <typename Struct, typename ... Args>
@@ -40,18 +58,18 @@ public:
     }
 
     template <typename Struct>
-    Writer onStructStart(const Struct& , RootNodeTag) { return *this; }
+    Writer& onStructStart(const Struct& , RootNodeTag) { return *this; }
 
     template <typename Struct>
     Writer onStructStart(const Struct& s, SequenceItemTag) {
-        return onStructStart(s, namedItemTag(defaultValueName));
+        return onStructStart(s, namedItemTag(defaultValueName()));
     }
 
     template <typename Struct, typename Tag>
     void onStructEnd(const Struct& , Tag) {}
 
     template<typename Map, typename Tag>
-    Writer onMapStart(const Map& m, Tag tag) {
+    auto onMapStart(const Map& m, Tag tag) -> decltype(this->onStructStart(m, tag)) {
         return onStructStart(m, tag);
     }
 
@@ -59,12 +77,16 @@ public:
     void onMapEnd(const Map&, Tag) {}
 
     template<typename Sequence, typename Tag>
-    Writer onSequenceStart(const Sequence& s, Tag tag) {
+    auto onSequenceStart(const Sequence& s, Tag tag) -> decltype(this->onStructStart(s, tag)) {
         return onStructStart(s, tag);
     }
 
 private:
-    std::string defaultValueName = "value";
+    static const std::string& defaultValueName() {
+        static const std::string value = "value";
+        return value;
+    }
+
     ptree* level_ = nullptr;
 
     ptree& level() const { return *level_; }
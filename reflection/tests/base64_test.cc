@@ -0,0 +1,137 @@
+#include <cctype>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <yamail/data/common/base64.h>
+#include <yamail/data/serialization/json_writer.h>
+#include <yamail/data/serialization/ptree_writer.h>
+#include <yamail/data/deserialization/json_reader.h>
+#include <yamail/data/deserialization/ptree_reader.h>
+
+namespace {
+
+using namespace yamail::data;
+namespace base64 = yamail::data::common::base64;
+
+struct Attachment {
+    std::string name;
+    reflection::Blob content;
+    reflection::BasicBlob<std::vector<char>> signature;
+};
+
+} // namespace
+
+BOOST_FUSION_ADAPT_STRUCT(Attachment, name, content, signature)
+
+namespace {
+
+std::string encode(const std::string& s) {
+    return base64::encode(reinterpret_cast<const unsigned char*>(s.data()), s.size());
+}
+
+boost::optional<std::string> decode(const std::string& s) {
+    std::string retval;
+    if (!base64::decode(s.data(), s.size(), retval)) {
+        return boost::none;
+    }
+    return retval;
+}
+
+std::string randomBytes(std::size_t n, std::mt19937& random) {
+    std::string retval(n, '\0');
+    for (auto& c : retval) {
+        c = static_cast<char>(random());
+    }
+    return retval;
+}
+
+TEST(Base64Test, encode_rfc4648Vectors) {
+    EXPECT_EQ("", encode(""));
+    EXPECT_EQ("Zg==", encode("f"));
+    EXPECT_EQ("Zm8=", encode("fo"));
+    EXPECT_EQ("Zm9v", encode("foo"));
+    EXPECT_EQ("Zm9vYg==", encode("foob"));
+    EXPECT_EQ("Zm9vYmE=", encode("fooba"));
+    EXPECT_EQ("Zm9vYmFy", encode("foobar"));
+    EXPECT_EQ("+/+/", encode("\xfb\xff\xbf"));
+}
+
+TEST(Base64Test, encodeEveryLength_sameAsScalar) {
+    std::mt19937 random(42);
+    for (std::size_t n = 0; n < 200; ++n) {
+        const std::string data = randomBytes(n, random);
+        std::string scalar(base64::encodedSize(n), '\0');
+        base64::encodeScalar(reinterpret_cast<const unsigned char*>(data.data()), n, &scalar[0]);
+        EXPECT_EQ(scalar, encode(data));
+        EXPECT_EQ(boost::optional<std::string>(data), decode(scalar));
+    }
+}
+
+TEST(Base64Test, decodeInvalidCharacterAtEveryOffset_returnFalse) {
+    std::mt19937 random(42);
+    const std::string text = encode(randomBytes(48, random));
+    for (std::size_t offset = 0; offset < text.size(); ++offset) {
+        for (int c = 0; c < 256; ++c) {
+            std::string s = text;
+            s[offset] = static_cast<char>(c);
+            const bool padding = c == '=' && offset + 1 == text.size();
+            const bool valid = std::isalnum(c) || c == '+' || c == '/' || padding;
+            EXPECT_EQ(valid, bool(decode(s))) << offset << " " << c;
+        }
+    }
+}
+
+TEST(Base64Test, decodeMalformedPadding_returnFalse) {
+    EXPECT_FALSE(decode("Zg="));
+    EXPECT_FALSE(decode("Z==="));
+    EXPECT_FALSE(decode("===="));
+    EXPECT_FALSE(decode("Zg==Zg=="));
+    EXPECT_FALSE(decode("Zm=v"));
+    EXPECT_EQ(boost::optional<std::string>("fo"), decode("Zm8="));
+}
+
+Attachment makeAttachment() {
+    Attachment retval;
+    retval.name = "photo.jpg";
+    for (int i = 0; i < 1000; ++i) {
+        retval.content.data.push_back(static_cast<std::uint8_t>(i * 7));
+    }
+    retval.signature.data = {'s', 'i', 'g', '\0', '\xff'};
+    return retval;
+}
+
+TEST(Base64Test, blobToJson_writeBase64String) {
+    Attachment a;
+    a.name = "a";
+    a.content.data = {'f', 'o', 'o'};
+    a.signature.data = {'f', 'o'};
+    EXPECT_EQ(R"json({"name":"a","content":"Zm9v","signature":"Zm8="})json",
+            serialization::toJson(a).str());
+    EXPECT_EQ(serialization::toJson(a).str(), serialization::yajl::toJson(a).str());
+    EXPECT_EQ(serialization::toJson(a).size(), serialization::jsonSize(a));
+}
+
+TEST(Base64Test, blobThroughJson_sameData) {
+    const Attachment a = makeAttachment();
+    const Attachment r = deserialization::fromJson<Attachment>(serialization::toJson(a).str());
+    EXPECT_EQ(a.content, r.content);
+    EXPECT_EQ(a.signature, r.signature);
+}
+
+TEST(Base64Test, blobThroughPtree_sameData) {
+    const Attachment a = makeAttachment();
+    auto tree = serialization::toPtree(a);
+    EXPECT_EQ("c2lnAP8=", tree.get<std::string>("signature"));
+    const Attachment r = deserialization::fromPtree<Attachment>(tree);
+    EXPECT_EQ(a.content, r.content);
+    EXPECT_EQ(a.signature, r.signature);
+}
+
+TEST(Base64Test, invalidBlobInJson_throwsJsonReaderError) {
+    EXPECT_THROW(deserialization::fromJson<Attachment>(
+            R"json({"name":"a","content":"Zm9v!","signature":""})json"), deserialization::JsonReaderError);
+}
+
+} // namespace
@@ -0,0 +1,34 @@
+#ifndef REFLECTION_TESTS_BENCH_BENCH_H_
+#define REFLECTION_TESTS_BENCH_BENCH_H_
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace bench {
+
+/**
+ * Returns the average wall time of a single call of f in microseconds.
+ */
+template <typename F>
+inline double measure(std::size_t iterations, F&& f) {
+    using clock = std::chrono::steady_clock;
+    f();
+    const auto start = clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        f();
+    }
+    const std::chrono::duration<double, std::micro> elapsed = clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+inline void report(const std::string& name, double us, double baselineUs) {
+    std::cout << std::left << std::setw(40) << name
+              << std::right << std::setw(12) << std::fixed << std::setprecision(1) << us << " us"
+              << std::setw(10) << std::setprecision(2) << baselineUs / us << "x" << std::endl;
+}
+
+} // namespace bench
+
+#endif /* REFLECTION_TESTS_BENCH_BENCH_H_ */
@@ -0,0 +1,135 @@
+#include <vector>
+
+#include <yamail/data/serialization/cbor_writer.h>
+#include <yamail/data/serialization/json_writer.h>
+#include <yamail/data/deserialization/cbor_reader.h>
+#include <yamail/data/deserialization/json_reader.h>
+
+#include "bench.h"
+
+/**
+ * Compares CBOR with JSON on the same mailbox: toCbor with toJson and
+ * toJsonRope, fromCbor with the streaming json::Reader
+ */
+
+namespace {
+
+struct Email {
+    std::string name;
+    std::string address;
+};
+
+class Recipient {
+public:
+    const std::string& type() const { return type_; }
+    void setType(const std::string& v) { type_ = v; }
+    const Email& email() const { return email_; }
+    void setEmail(const Email& v) { email_ = v; }
+private:
+    std::string type_;
+    Email email_;
+};
+
+struct Message {
+    std::string id;
+    std::string subject;
+    std::vector<Recipient> recipients;
+    std::string body;
+    long date;
+    boost::optional<int> size;
+};
+
+struct Mailbox {
+    std::vector<Message> messages;
+};
+
+} // namespace
+
+BOOST_FUSION_ADAPT_STRUCT(Email, name, address)
+
+BOOST_FUSION_ADAPT_ADT(Recipient,
+    (YR_GET_WITH_NAME(type), YR_SET_WITH_NAME(setType))
+    (YR_GET_WITH_NAME(email), YR_SET_WITH_NAME(setEmail))
+)
+
+BOOST_FUSION_ADAPT_STRUCT(Message, id, subject, recipients, body, date, size)
+
+BOOST_FUSION_ADAPT_STRUCT(Mailbox, messages)
+
+namespace {
+
+Mailbox makeMailbox(std::size_t messages, std::size_t bodySize) {
+    Mailbox retval;
+    for (std::size_t i = 0; i < messages; ++i) {
+        Message m;
+        m.id = std::to_string(100500 + i);
+        m.subject = "Subject of the message number " + m.id;
+        for (std::size_t j = 0; j < 3; ++j) {
+            Recipient r;
+            r.setType(j ? "to" : "from");
+            r.setEmail(Email{"Vasya Pupkin", "vasya" + std::to_string(j) + "@yandex.ru"});
+            m.recipients.push_back(r);
+        }
+        m.body = std::string(bodySize, 'a');
+        m.date = 1460000000 + i;
+        m.size = bodySize;
+        retval.messages.push_back(std::move(m));
+    }
+    return retval;
+}
+
+} // namespace
+
+int main() {
+    using namespace yamail::data;
+
+    std::cout << std::left << std::setw(40) << "messages x body bytes"
+              << std::right << std::setw(15) << "time" << std::setw(11) << "speedup" << std::endl;
+
+    for (const auto bodySize : {16u, 1024u, 9216u}) {
+        for (const auto count : {10u, 100u, 1000u}) {
+            const Mailbox mailbox = makeMailbox(count, bodySize);
+            const std::string json = serialization::toJson(mailbox).str();
+            const std::string cbor = serialization::toCbor(mailbox);
+            const std::size_t iterations = std::max<std::size_t>(1, 2000000 / json.size());
+            std::size_t total = 0;
+
+            const auto toJson = bench::measure(iterations, [&] {
+                total += serialization::toJson(mailbox).size();
+            });
+            const auto toJsonRope = bench::measure(iterations, [&] {
+                total += serialization::toJsonRope(mailbox, "mailbox", 1024).size();
+            });
+            const auto toCbor = bench::measure(iterations, [&] {
+                total += serialization::toCbor(mailbox).size();
+            });
+            const auto toCborRope = bench::measure(iterations, [&] {
+                total += serialization::toCborRope(mailbox, "mailbox", 1024).size();
+            });
+            const auto fromJson = bench::measure(iterations, [&] {
+                Mailbox m;
+                deserialization::fromJson(json, m);
+                total += m.messages.size();
+            });
+            const auto fromCbor = bench::measure(iterations, [&] {
+                Mailbox m;
+                deserialization::fromCbor(cbor, m);
+                total += m.messages.size();
+            });
+
+            const auto name = std::to_string(count) + " x " + std::to_string(bodySize);
+            std::cout << name << ": json " << json.size() << " bytes, cbor " << cbor.size()
+                      << " bytes" << std::endl;
+            bench::report(name + " toJson", toJson, toJson);
+            bench::report(name + " toCbor", toCbor, toJson);
+            bench::report(name + " toJsonRope", toJsonRope, toJsonRope);
+            bench::report(name + " toCborRope", toCborRope, toJsonRope);
+            bench::report(name + " fromJson", fromJson, fromJson);
+            bench::report(name + " fromCbor", fromCbor, fromJson);
+            if (!total) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
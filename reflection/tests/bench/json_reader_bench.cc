@@ -0,0 +1,107 @@
+#include <vector>
+
+#include <yamail/data/serialization/json_writer.h>
+#include <yamail/data/deserialization/json_reader.h>
+
+#include "bench.h"
+
+/**
+ * Compares the streaming json::Reader with the jsonToPtree + fromPtree round trip
+ */
+
+namespace {
+
+struct Email {
+    std::string name;
+    std::string address;
+};
+
+class Recipient {
+public:
+    const std::string& type() const { return type_; }
+    void setType(const std::string& v) { type_ = v; }
+    const Email& email() const { return email_; }
+    void setEmail(const Email& v) { email_ = v; }
+private:
+    std::string type_;
+    Email email_;
+};
+
+struct Message {
+    std::string id;
+    std::string subject;
+    std::vector<Recipient> recipients;
+    std::string body;
+    long date;
+    boost::optional<int> size;
+};
+
+struct Mailbox {
+    std::vector<Message> messages;
+};
+
+} // namespace
+
+BOOST_FUSION_ADAPT_STRUCT(Email, name, address)
+
+BOOST_FUSION_ADAPT_ADT(Recipient,
+    (YR_GET_WITH_NAME(type), YR_SET_WITH_NAME(setType))
+    (YR_GET_WITH_NAME(email), YR_SET_WITH_NAME(setEmail))
+)
+
+BOOST_FUSION_ADAPT_STRUCT(Message, id, subject, recipients, body, date, size)
+
+BOOST_FUSION_ADAPT_STRUCT(Mailbox, messages)
+
+namespace {
+
+Mailbox makeMailbox(std::size_t messages, std::size_t bodySize) {
+    Mailbox retval;
+    for (std::size_t i = 0; i < messages; ++i) {
+        Message m;
+        m.id = std::to_string(100500 + i);
+        m.subject = "Subject of the message number " + m.id;
+        for (std::size_t j = 0; j < 3; ++j) {
+            Recipient r;
+            r.setType(j ? "to" : "from");
+            r.setEmail(Email{"Vasya Pupkin", "vasya" + std::to_string(j) + "@yandex.ru"});
+            m.recipients.push_back(r);
+        }
+        m.body = std::string(bodySize, 'a');
+        m.date = 1460000000 + i;
+        m.size = bodySize;
+        retval.messages.push_back(std::move(m));
+    }
+    return retval;
+}
+
+} // namespace
+
+int main() {
+    using namespace yamail::data;
+
+    std::cout << std::left << std::setw(40) << "messages x body bytes"
+              << std::right << std::setw(15) << "time" << std::setw(11) << "speedup" << std::endl;
+
+    for (const auto bodySize : {16u, 1024u, 9216u}) {
+        for (const auto count : {10u, 100u, 1000u}) {
+            const std::string json = serialization::toJson(makeMailbox(count, bodySize)).str();
+            const std::size_t iterations = std::max<std::size_t>(1, 2000000 / json.size());
+
+            const auto ptree = bench::measure(iterations, [&] {
+                auto tree = common::jsonToPtree(json);
+                Mailbox m;
+                deserialization::fromPtree(tree, m);
+            });
+            const auto sax = bench::measure(iterations, [&] {
+                Mailbox m;
+                deserialization::fromJson(json, m);
+            });
+
+            const auto name = std::to_string(count) + " x " + std::to_string(bodySize);
+            bench::report(name + " jsonToPtree+fromPtree", ptree, ptree);
+            bench::report(name + " json::Reader", sax, ptree);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include <string>
+
+#include <yamail/data/common/json_to_ptree.h>
+
+#include "bench.h"
+
+/**
+ * Shows how jsonToPtree scales with the nesting depth - the time per node
+ * should stay flat while the document gets deeper.
+ */
+
+namespace {
+
+/**
+ * {"f0":"value",...,"child":{"f0":"value",...,"child":{...}}} - depth levels
+ * with width scalar fields each.
+ */
+std::string makeNested(std::size_t depth, std::size_t width) {
+    std::string fields;
+    for (std::size_t i = 0; i < width; ++i) {
+        fields += "\"f" + std::to_string(i) + "\":\"value\",";
+    }
+    std::string retval;
+    for (std::size_t i = 0; i < depth; ++i) {
+        retval += "{" + fields + "\"child\":";
+    }
+    retval += "{}";
+    retval.append(depth, '}');
+    return retval;
+}
+
+} // namespace
+
+int main() {
+    using namespace yamail::data;
+
+    std::cout << std::left << std::setw(40) << "depth x width"
+              << std::right << std::setw(15) << "time" << std::setw(15) << "per node" << std::endl;
+
+    for (const auto width : {1u, 16u}) {
+        for (const auto depth : {1u, 8u, 64u, 256u, 1024u}) {
+            const std::string json = makeNested(depth, width);
+            const std::size_t nodes = depth * (width + 1) + 1;
+            const std::size_t iterations = std::max<std::size_t>(1, 4000000 / json.size());
+
+            const auto us = bench::measure(iterations, [&] {
+                common::jsonToPtree(json);
+            });
+
+            std::cout << std::left << std::setw(40) << (std::to_string(depth) + " x " + std::to_string(width))
+                      << std::right << std::setw(12) << std::fixed << std::setprecision(1) << us << " us"
+                      << std::setw(12) << std::setprecision(1) << us * 1000 / nodes << " ns" << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include <vector>
+
+#include <yamail/data/serialization/json_writer.h>
+
+#include "bench.h"
+
+/**
+ * Compares the native json::Generator backend of toJson and toJsonRope with
+ * yajl_gen, each produces the reply content
+ */
+
+namespace {
+
+struct Email {
+    std::string name;
+    std::string address;
+};
+
+struct Message {
+    std::string id;
+    std::string subject;
+    std::vector<Email> recipients;
+    std::string body;
+    long date;
+};
+
+struct Mailbox {
+    std::vector<Message> messages;
+};
+
+} // namespace
+
+BOOST_FUSION_ADAPT_STRUCT(Email, name, address)
+
+BOOST_FUSION_ADAPT_STRUCT(Message, id, subject, recipients, body, date)
+
+BOOST_FUSION_ADAPT_STRUCT(Mailbox, messages)
+
+namespace {
+
+Mailbox makeMailbox(std::size_t messages, std::size_t bodySize) {
+    const std::string line = "Lorem ipsum dolor sit amet, consectetur adipiscing elit. ";
+    Mailbox retval;
+    for (std::size_t i = 0; i < messages; ++i) {
+        Message m;
+        m.id = std::to_string(100500 + i);
+        m.subject = "Subject of the message number " + m.id;
+        for (std::size_t j = 0; j < 3; ++j) {
+            m.recipients.push_back(Email{"Vasya Pupkin", "vasya" + std::to_string(j) + "@yandex.ru"});
+        }
+        while (m.body.size() < bodySize) {
+            m.body += line;
+        }
+        m.body.resize(bodySize);
+        m.date = 1460000000 + i;
+        retval.messages.push_back(std::move(m));
+    }
+    return retval;
+}
+
+} // namespace
+
+int main() {
+    using namespace yamail::data;
+
+    std::cout << std::left << std::setw(40) << "messages x body bytes"
+              << std::right << std::setw(15) << "time" << std::setw(11) << "speedup" << std::endl;
+
+    for (const auto bodySize : {16u, 1024u, 9216u}) {
+        for (const auto count : {10u, 100u, 1000u}) {
+            const Mailbox mailbox = makeMailbox(count, bodySize);
+            const std::size_t iterations = std::max<std::size_t>(1, 20000000 / (count * bodySize));
+
+            const auto yajl = bench::measure(iterations, [&] {
+                const std::string content = serialization::yajl::toJson(mailbox, "messages").str();
+            });
+            const auto native = bench::measure(iterations, [&] {
+                const std::string content = serialization::toJson(mailbox, "messages").release();
+            });
+
+            const auto rope = bench::measure(iterations, [&] {
+                const auto content = serialization::toJsonRope(mailbox, "messages");
+            });
+
+            const auto references = bench::measure(iterations, [&] {
+                const auto content = serialization::toJsonRope(mailbox, "messages", 1024);
+            });
+
+            const auto name = std::to_string(count) + " x " + std::to_string(bodySize);
+            bench::report(name + " yajl_gen", yajl, yajl);
+            bench::report(name + " json::Generator", native, yajl);
+            bench::report(name + " json::Rope", rope, yajl);
+            bench::report(name + " json::Rope references", references, yajl);
+        }
+    }
+    return 0;
+}
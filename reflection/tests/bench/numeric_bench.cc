@@ -0,0 +1,128 @@
+#include <cstdio>
+#include <deque>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+#include <yamail/data/common/numeric_format.h>
+#include <yamail/data/serialization/json_writer.h>
+#include <yamail/data/serialization/ptree_writer.h>
+
+#include "bench.h"
+
+/**
+ * Compares formatNumber with the formatting it replaces in the writers:
+ * printf of yajl_gen_double for the floating point numbers and
+ * boost::lexical_cast for the integers, then writes numeric arrays by toJson
+ * item by item and by onArithmeticRange
+ */
+
+namespace {
+
+struct Sample {
+    double value;
+    float ratio;
+    long date;
+    std::size_t size;
+    unsigned count;
+};
+
+struct Series {
+    std::vector<double> values;
+    std::vector<Sample> samples;
+};
+
+} // namespace
+
+BOOST_FUSION_ADAPT_STRUCT(Sample, value, ratio, date, size, count)
+
+BOOST_FUSION_ADAPT_STRUCT(Series, values, samples)
+
+namespace {
+
+Series makeSeries(std::size_t count) {
+    std::mt19937_64 random(42);
+    std::uniform_real_distribution<double> real(-1e6, 1e6);
+    Series retval;
+    for (std::size_t i = 0; i < count; ++i) {
+        retval.values.push_back(real(random));
+        retval.samples.push_back(Sample{real(random), static_cast<float>(real(random)),
+                1460000000 + static_cast<long>(i), static_cast<std::size_t>(random()),
+                static_cast<unsigned>(random())});
+    }
+    return retval;
+}
+
+} // namespace
+
+int main() {
+    using namespace yamail::data;
+
+    std::cout << std::left << std::setw(40) << "numbers"
+              << std::right << std::setw(15) << "time" << std::setw(11) << "speedup" << std::endl;
+
+    const std::size_t count = 100000;
+    const Series series = makeSeries(count);
+    char buf[common::numeric::bufferSize];
+    std::size_t total = 0;
+
+    const auto printf = bench::measure(10, [&] {
+        for (const auto v : series.values) {
+            total += std::snprintf(buf, sizeof(buf), "%.20g", v);
+        }
+    });
+    const auto doubles = bench::measure(10, [&] {
+        for (const auto v : series.values) {
+            total += common::formatNumber(buf, v) - buf;
+        }
+    });
+    bench::report("100000 doubles printf %.20g", printf, printf);
+    bench::report("100000 doubles formatNumber", doubles, printf);
+
+    const auto lexicalCast = bench::measure(10, [&] {
+        for (const auto& s : series.samples) {
+            total += boost::lexical_cast<std::string>(s.count).size();
+        }
+    });
+    const auto integers = bench::measure(10, [&] {
+        for (const auto& s : series.samples) {
+            total += common::formatNumber(buf, s.count) - buf;
+        }
+    });
+    bench::report("100000 unsigned lexical_cast", lexicalCast, lexicalCast);
+    bench::report("100000 unsigned formatNumber", integers, lexicalCast);
+
+    const std::deque<double> items(series.values.begin(), series.values.end());
+    const auto itemByItem = bench::measure(10, [&] {
+        total += serialization::toJson(items).size();
+    });
+    const auto range = bench::measure(10, [&] {
+        total += serialization::toJson(series.values).size();
+    });
+    bench::report("100000 doubles toJson item by item", itemByItem, itemByItem);
+    bench::report("100000 doubles toJson onArithmeticRange", range, itemByItem);
+
+    std::vector<int> ints(count);
+    std::iota(ints.begin(), ints.end(), -50000);
+    const std::deque<int> intItems(ints.begin(), ints.end());
+    const auto intItemByItem = bench::measure(10, [&] {
+        total += serialization::toJson(intItems).size();
+    });
+    const auto intRange = bench::measure(10, [&] {
+        total += serialization::toJson(ints).size();
+    });
+    bench::report("100000 ints toJson item by item", intItemByItem, intItemByItem);
+    bench::report("100000 ints toJson onArithmeticRange", intRange, intItemByItem);
+
+    const auto json = bench::measure(10, [&] {
+        total += serialization::toJson(series, "series").size();
+    });
+    const auto ptree = bench::measure(10, [&] {
+        total += serialization::toPtree(series).size();
+    });
+    bench::report("100000 x 6 numbers toJson", json, json);
+    bench::report("100000 x 6 numbers toPtree", ptree, ptree);
+
+    return total == 0;
+}
@@ -0,0 +1,280 @@
+#include <array>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include <gtest/gtest.h>
+#include <yamail/data/serialization/cbor_writer.h>
+#include <yamail/data/deserialization/cbor_reader.h>
+
+namespace {
+
+using namespace yamail::data;
+using serialization::toCbor;
+using deserialization::fromCbor;
+using deserialization::CborReaderError;
+
+struct Point {
+    int x;
+    double y;
+};
+
+struct Shape {
+    std::string name;
+    bool closed;
+    std::vector<Point> points;
+    std::map<std::string, std::string> labels;
+    boost::optional<std::string> color;
+    boost::optional<unsigned> layer;
+    std::vector<boost::optional<int>> marks;
+    std::shared_ptr<Point> origin;
+    std::unique_ptr<Point> pivot;
+    std::tuple<int, std::string> tag;
+    std::vector<double> weights;
+    std::array<float, 2> scale;
+    long long id;
+    reflection::Blob thumbnail;
+};
+
+class Owner {
+public:
+    const std::string& name() const { return name_; }
+    void setName(std::string name) { name_ = std::move(name); }
+    const Point& home() const { return home_; }
+    void setHome(Point home) { home_ = home; }
+
+private:
+    std::string name_;
+    Point home_{0, 0};
+};
+
+} // namespace
+
+BOOST_FUSION_ADAPT_STRUCT(Point, x, y)
+
+BOOST_FUSION_ADAPT_STRUCT(Shape, name, closed, points, labels, color, layer, marks, origin, pivot,
+        tag, weights, scale, id, thumbnail)
+
+BOOST_FUSION_ADAPT_ADT(Owner,
+    (YR_GET_WITH_NAME(name), YR_SET_WITH_NAME(setName))
+    (YR_GET_WITH_NAME(home), YR_SET_WITH_NAME(setHome))
+)
+
+namespace {
+
+std::string hex(const std::string& s) {
+    static const char digits[] = "0123456789abcdef";
+    std::string retval;
+    for (const char c : s) {
+        retval += digits[static_cast<unsigned char>(c) >> 4];
+        retval += digits[static_cast<unsigned char>(c) & 0xf];
+    }
+    return retval;
+}
+
+std::string unhex(const std::string& s) {
+    std::string retval;
+    for (std::size_t i = 0; i + 1 < s.size(); i += 2) {
+        retval += static_cast<char>(std::stoi(s.substr(i, 2), nullptr, 16));
+    }
+    return retval;
+}
+
+bool operator==(const Point& lhs, const Point& rhs) {
+    return lhs.x == rhs.x && lhs.y == rhs.y;
+}
+
+TEST(CborTest, integers_writeRfc8949Encoding) {
+    EXPECT_EQ("00", hex(toCbor(0)));
+    EXPECT_EQ("17", hex(toCbor(23)));
+    EXPECT_EQ("1818", hex(toCbor(24)));
+    EXPECT_EQ("1864", hex(toCbor(100)));
+    EXPECT_EQ("1903e8", hex(toCbor(1000)));
+    EXPECT_EQ("1a000f4240", hex(toCbor(1000000)));
+    EXPECT_EQ("1b000000e8d4a51000", hex(toCbor(1000000000000LL)));
+    EXPECT_EQ("1bffffffffffffffff", hex(toCbor(18446744073709551615ULL)));
+    EXPECT_EQ("20", hex(toCbor(-1)));
+    EXPECT_EQ("29", hex(toCbor(-10)));
+    EXPECT_EQ("3863", hex(toCbor(-100)));
+    EXPECT_EQ("3903e7", hex(toCbor(-1000)));
+    EXPECT_EQ("3b7fffffffffffffff", hex(toCbor(std::numeric_limits<long long>::min())));
+}
+
+TEST(CborTest, scalars_writeRfc8949Encoding) {
+    EXPECT_EQ("fb3ff199999999999a", hex(toCbor(1.1)));
+    EXPECT_EQ("fa47c35000", hex(toCbor(100000.0f)));
+    EXPECT_EQ("f5", hex(toCbor(true)));
+    EXPECT_EQ("f4", hex(toCbor(false)));
+    EXPECT_EQ("60", hex(toCbor(std::string())));
+    EXPECT_EQ("6449455446", hex(toCbor(std::string("IETF"))));
+    EXPECT_EQ("80", hex(toCbor(std::vector<std::string>())));
+    EXPECT_EQ("83010203", hex(toCbor(std::vector<int>{1, 2, 3})));
+    EXPECT_EQ("4401020304", hex(toCbor(reflection::Blob({1, 2, 3, 4}))));
+}
+
+TEST(CborTest, struct_writeIndefiniteMapWithTextKeys) {
+    EXPECT_EQ("bf6178016179fb3ff8000000000000ff", hex(toCbor(Point{1, 1.5})));
+    EXPECT_EQ("bf6470696e74bf617801617902ffff", hex(toCbor(std::map<std::string, std::map<std::string, int>>{
+            {"pint", {{"x", 1}, {"y", 2}}}})));
+}
+
+TEST(CborTest, rootName_writeMapWithOneKey) {
+    const std::string cbor = toCbor(Point{1, 2}, "point");
+    EXPECT_EQ("bf65706f696e74bf", hex(cbor.substr(0, 8)));
+    EXPECT_EQ(Point({1, 2}), fromCbor<Point>(cbor, "point"));
+}
+
+TEST(CborTest, rope_sameAsStringAndReferenceLongStrings) {
+    Shape s;
+    s.name = std::string(2000, 'n');
+    s.labels = {{"a", "first"}, {"b", std::string(3000, 'b')}};
+    const auto rope = serialization::toCborRope(s, "shape", 1024);
+    EXPECT_EQ(toCbor(s, "shape"), rope.str());
+    std::size_t referenced = 0;
+    for (const auto& segment : rope.segments()) {
+        referenced += segment.data == s.name.data() || segment.data == s.labels["b"].data();
+    }
+    EXPECT_EQ(2u, referenced);
+    EXPECT_EQ(toCbor(s, "shape"), serialization::toCborRope(s, "shape").str());
+}
+
+TEST(CborTest, absentOptionalsAndNullPointers_omittedInStructNullInSequence) {
+    Shape s;
+    s.marks = {1, boost::none, 3};
+    const std::string cbor = toCbor(s.marks);
+    EXPECT_EQ("8301f603", hex(cbor));
+    const std::string shape = toCbor(s);
+    EXPECT_EQ(std::string::npos, shape.find("color"));
+    EXPECT_EQ(std::string::npos, shape.find("origin"));
+    EXPECT_NE(std::string::npos, shape.find("marks"));
+}
+
+Shape makeShape() {
+    Shape s;
+    s.name = "polygon";
+    s.closed = true;
+    s.points = {{1, 0.5}, {-2, 1e300}, {1 << 30, -0.0}};
+    s.labels = {{"a", "first"}, {"b", std::string(300, 'b')}};
+    s.color = std::string("red");
+    s.marks = {7, boost::none, -7};
+    s.origin = std::make_shared<Point>(Point{3, 4});
+    s.tag = std::make_tuple(42, "answer");
+    s.weights = {0.1, 0.2, 0.30000000000000004};
+    s.scale = {{1.5f, 0.1f}};
+    s.id = -5000000000LL;
+    s.thumbnail.data = {0, 1, 2, 0xff};
+    return s;
+}
+
+void expectSame(const Shape& expected, const Shape& actual) {
+    EXPECT_EQ(expected.name, actual.name);
+    EXPECT_EQ(expected.closed, actual.closed);
+    EXPECT_EQ(expected.points, actual.points);
+    EXPECT_EQ(expected.labels, actual.labels);
+    EXPECT_EQ(expected.color, actual.color);
+    EXPECT_EQ(expected.layer, actual.layer);
+    EXPECT_EQ(expected.marks, actual.marks);
+    ASSERT_EQ(bool(expected.origin), bool(actual.origin));
+    if (expected.origin) {
+        EXPECT_EQ(*expected.origin, *actual.origin);
+    }
+    EXPECT_EQ(bool(expected.pivot), bool(actual.pivot));
+    EXPECT_EQ(expected.tag, actual.tag);
+    EXPECT_EQ(expected.weights, actual.weights);
+    EXPECT_EQ(expected.scale, actual.scale);
+    EXPECT_EQ(expected.id, actual.id);
+    EXPECT_EQ(expected.thumbnail, actual.thumbnail);
+}
+
+TEST(CborTest, struct_roundTripEveryCategory) {
+    const Shape s = makeShape();
+    expectSame(s, fromCbor<Shape>(toCbor(s)));
+    EXPECT_EQ(toCbor(s).size(), serialization::cborSize(s));
+    EXPECT_EQ(toCbor(s, "shape").size(), serialization::cborSize(s, "shape"));
+}
+
+TEST(CborTest, emptyStruct_roundTrip) {
+    const Shape s{};
+    expectSame(s, fromCbor<Shape>(toCbor(s)));
+}
+
+TEST(CborTest, readIntoUsedObject_resetAbsentOptionalsAndPointers) {
+    Shape s = makeShape();
+    fromCbor(toCbor(Shape{}), s);
+    EXPECT_FALSE(s.color);
+    EXPECT_FALSE(s.origin);
+    EXPECT_TRUE(s.points.empty());
+}
+
+TEST(CborTest, adt_roundTripThroughSetters) {
+    Owner o;
+    o.setName("owner");
+    o.setHome(Point{5, 6});
+    const Owner r = fromCbor<Owner>(toCbor(o));
+    EXPECT_EQ("owner", r.name());
+    EXPECT_EQ(Point({5, 6}), r.home());
+}
+
+TEST(CborTest, fixedArrays_roundTrip) {
+    const int ints[3] = {1, -2, 3};
+    int read[3] = {};
+    fromCbor(toCbor(ints), read);
+    EXPECT_EQ(std::vector<int>(ints, ints + 3), std::vector<int>(read, read + 3));
+}
+
+TEST(CborTest, fieldsOutOfOrderAndUnknown_readByName) {
+    // {"z": [1, {"a": 1}], "y": 2.5, "x": 7}
+    const std::string cbor = unhex("a3617a8201a16161016179f94100617807");
+    EXPECT_EQ(Point({7, 2.5}), fromCbor<Point>(cbor));
+}
+
+TEST(CborTest, largeMapInOtherOrder_readByName) {
+    std::unordered_map<std::string, int> m;
+    for (int i = 0; i < 1000; ++i) {
+        m[std::to_string(i)] = i;
+    }
+    const auto r = fromCbor<std::map<std::string, int>>(toCbor(m));
+    ASSERT_EQ(m.size(), r.size());
+    for (const auto& i : r) {
+        EXPECT_EQ(m.at(i.first), i.second);
+    }
+}
+
+TEST(CborTest, rfc8949Items_read) {
+    EXPECT_EQ(1.0, fromCbor<double>(unhex("f93c00")));
+    EXPECT_EQ(65504.0, fromCbor<double>(unhex("f97bff")));
+    EXPECT_EQ(5.960464477539063e-8, fromCbor<double>(unhex("f90001")));
+    EXPECT_EQ(-4.0, fromCbor<double>(unhex("f9c400")));
+    EXPECT_EQ(100000.0, fromCbor<double>(unhex("fa47c35000")));
+    EXPECT_EQ(-1000.0, fromCbor<double>(unhex("3903e7")));
+    EXPECT_EQ(1363896240, fromCbor<long>(unhex("c11a514b67b0")));
+    EXPECT_EQ("streaming", fromCbor<std::string>(unhex("7f657374726561646d696e67ff")));
+    EXPECT_EQ(std::vector<int>({1, 2, 3, 4, 5}), fromCbor<std::vector<int>>(unhex("9f0102030405ff")));
+    EXPECT_EQ(std::vector<std::vector<int>>({{1}, {2, 3}, {4, 5}}),
+            fromCbor<std::vector<std::vector<int>>>(unhex("838101820203820405")));
+}
+
+TEST(CborTest, malformedData_throwCborReaderError) {
+    EXPECT_THROW(fromCbor<int>(""), CborReaderError);
+    EXPECT_THROW(fromCbor<int>(unhex("19")), CborReaderError);
+    EXPECT_THROW(fromCbor<std::string>(unhex("644945")), CborReaderError);
+    EXPECT_THROW(fromCbor<std::vector<int>>(unhex("9b00000000ffffffff00")), CborReaderError);
+    EXPECT_THROW(fromCbor<int>(unhex("0000")), CborReaderError);
+    EXPECT_THROW(fromCbor<int>(unhex("1c")), CborReaderError);
+    const std::string deep = unhex("a3617801617902617a") + std::string(2000000, '\x81') + unhex("00");
+    EXPECT_THROW(fromCbor<Point>(deep), CborReaderError);
+}
+
+TEST(CborTest, typeMismatch_throwCborReaderError) {
+    EXPECT_THROW(fromCbor<int>(toCbor(std::string("1"))), CborReaderError);
+    EXPECT_THROW(fromCbor<unsigned>(toCbor(-1)), CborReaderError);
+    EXPECT_THROW(fromCbor<short>(toCbor(70000)), CborReaderError);
+    EXPECT_THROW(fromCbor<bool>(toCbor(1)), CborReaderError);
+    EXPECT_THROW(fromCbor<Point>(toCbor(std::vector<int>{1, 2})), CborReaderError);
+    EXPECT_THROW(fromCbor<std::vector<int>>(toCbor(Point{1, 2})), CborReaderError);
+    EXPECT_THROW(fromCbor<Point>(unhex("a1617801")), CborReaderError);
+}
+
+} // namespace
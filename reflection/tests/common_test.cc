@@ -2,6 +2,7 @@
 #include <vector>
 #include <deque>
 #include <map>
+#include <numeric>
 
 #include <boost/fusion/mpl.hpp>
 #include <boost/fusion/adapted.hpp>
@@ -347,3 +348,86 @@ TEST(ReflectionTest, deserializeDStructJson) {
     const auto dObj2 = yamail::data::deserialization::fromPtree<DStruct>(p);
     ASSERT_TRUE( dObj == dObj2 );
 }
+
+struct BorrowingCounter : public yamail::data::reflection::Visitor {
+    BorrowingCounter() = default;
+    BorrowingCounter(const BorrowingCounter&) = delete;
+
+    template<typename Value, typename Tag>
+    void onValue(const Value&, Tag) { ++values; }
+
+    template<typename Struct, typename Tag>
+    BorrowingCounter& onStructStart(const Struct&, Tag) { return *this; }
+
+    template<typename Map, typename Tag>
+    BorrowingCounter& onMapStart(const Map&, Tag) { return *this; }
+
+    template<typename Sequence, typename Tag>
+    BorrowingCounter& onSequenceStart(const Sequence&, Tag) { return *this; }
+
+    std::size_t values = 0;
+};
+
+TEST(ReflectionTest, borrowingVisitor_visitsNestedItemsWithoutCopies) {
+    std::vector<AClass> objects(2);
+    objects[0].init();
+    objects[1].init();
+    const std::map<std::string, std::vector<AClass>> map = {{"objects", objects}};
+
+    BorrowingCounter counter;
+    yamail::data::reflection::applyVisitor(map, counter, yamail::data::reflection::SequenceItemTag{});
+
+    ASSERT_EQ(8u, counter.values);
+}
+
+struct RangeCounter : public yamail::data::reflection::Visitor {
+    using Visitor::onArithmeticRange;
+
+    template<typename Value, typename Tag>
+    void onValue(const Value&, Tag) { ++values; }
+
+    template<typename Sequence, typename Tag>
+    RangeCounter& onSequenceStart(const Sequence&, Tag) { return *this; }
+
+    bool onArithmeticRange(const int* data, std::size_t size, yamail::data::reflection::SequenceItemTag) {
+        ++ranges;
+        items += size;
+        sum += std::accumulate(data, data + size, 0);
+        return true;
+    }
+
+    std::size_t values = 0;
+    std::size_t ranges = 0;
+    std::size_t items = 0;
+    int sum = 0;
+};
+
+TEST(ReflectionTest, arithmeticSequences_visitedAsRanges) {
+    using yamail::data::reflection::applyVisitor;
+    using yamail::data::reflection::SequenceItemTag;
+    const std::vector<int> vector = {1, 2, 3};
+    const int array[2] = {4, 5};
+    const std::array<int, 1> stdArray = {{6}};
+
+    RangeCounter counter;
+    applyVisitor(vector, counter, SequenceItemTag{});
+    applyVisitor(array, counter, SequenceItemTag{});
+    applyVisitor(stdArray, counter, SequenceItemTag{});
+
+    ASSERT_EQ(3u, counter.ranges);
+    ASSERT_EQ(6u, counter.items);
+    ASSERT_EQ(21, counter.sum);
+    ASSERT_EQ(0u, counter.values);
+}
+
+TEST(ReflectionTest, arithmeticRangeNotTaken_visitedItemByItem) {
+    const std::vector<double> doubles = {1.0, 2.0};
+    const std::deque<int> deque = {1, 2, 3};
+
+    RangeCounter counter;
+    yamail::data::reflection::applyVisitor(doubles, counter, yamail::data::reflection::SequenceItemTag{});
+    yamail::data::reflection::applyVisitor(deque, counter, yamail::data::reflection::SequenceItemTag{});
+
+    ASSERT_EQ(0u, counter.ranges);
+    ASSERT_EQ(5u, counter.values);
+}
@@ -0,0 +1,182 @@
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <boost/optional.hpp>
+#include <yamail/data/reflection/field_mask.h>
+#include <yamail/data/serialization/json_writer.h>
+#include <yamail/data/serialization/protobuf_writer.h>
+#include <yamail/data/deserialization/json_reader.h>
+#include <yamail/data/deserialization/protobuf_reader.h>
+
+using namespace yamail::data::reflection;
+using namespace yamail::data::serialization;
+
+namespace {
+
+struct Address {
+    std::string name;
+    std::string domain;
+};
+
+struct Contact {
+    std::string kind;
+    Address address;
+};
+
+struct Letter {
+    std::string id;
+    std::string subject;
+    std::vector<Contact> contacts;
+    boost::optional<Address> replyTo;
+    std::string body;
+};
+
+class Counted {
+public:
+    int cheap() const { return 1; }
+    void setCheap(int) {}
+    const std::string& expensive() const { ++calls; return text_; }
+    void setExpensive(const std::string& v) { text_ = v; }
+
+    static int calls;
+private:
+    std::string text_ = "text";
+};
+
+int Counted::calls = 0;
+
+} // namespace
+
+BOOST_FUSION_ADAPT_STRUCT(Address, name, domain)
+BOOST_FUSION_ADAPT_STRUCT(Contact, kind, address)
+BOOST_FUSION_ADAPT_STRUCT(Letter, id, subject, contacts, replyTo, body)
+
+BOOST_FUSION_ADAPT_ADT(Counted,
+    (YR_GET_WITH_NAME(cheap), YR_SET_WITH_NAME(setCheap))
+    (YR_GET_WITH_NAME(expensive), YR_SET_WITH_NAME(setExpensive))
+)
+
+YR_PROTOBUF_FIELDS(Address, 1, 2)
+YR_PROTOBUF_FIELDS(Contact, 1, 2)
+YR_PROTOBUF_FIELDS(Letter, 1, 2, 3, 4, 5)
+
+namespace {
+
+Letter makeLetter() {
+    Letter retval;
+    retval.id = "42";
+    retval.subject = "hello";
+    retval.contacts = {{"to", {"ozzy", "example.com"}}, {"cc", {"vasya", "example.org"}}};
+    retval.replyTo = Address{"noreply", "example.com"};
+    retval.body = "the huge text";
+    return retval;
+}
+
+std::string masked(const Letter& value, const std::string& fields) {
+    const FieldMask mask = parseFieldMask<Letter>(fields);
+    const FieldMaskScope scope(mask);
+    return toJson(value).str();
+}
+
+} // namespace
+
+TEST(FieldMaskTest, emptyList_selectEverything) {
+    const Letter value = makeLetter();
+    EXPECT_TRUE(parseFieldMask<Letter>("").empty());
+    EXPECT_EQ(toJson(value).str(), masked(value, ""));
+}
+
+TEST(FieldMaskTest, topLevelFields_writeSelectedOnly) {
+    EXPECT_EQ(R"({"id":"42","subject":"hello"})", masked(makeLetter(), "id,subject"));
+    EXPECT_EQ(R"({"subject":"hello","body":"the huge text"})", masked(makeLetter(), "body,subject"));
+}
+
+TEST(FieldMaskTest, pathThroughSequence_restrictItemType) {
+    EXPECT_EQ(R"({"id":"42","contacts":[{"address":{"name":"ozzy"}},{"address":{"name":"vasya"}}]})",
+            masked(makeLetter(), "id,contacts.address.name"));
+}
+
+TEST(FieldMaskTest, memberWithoutSubpath_writeWhole) {
+    EXPECT_EQ(R"({"contacts":[{"kind":"to","address":{"name":"ozzy","domain":"example.com"}},)"
+              R"({"kind":"cc","address":{"name":"vasya","domain":"example.org"}}]})",
+            masked(makeLetter(), "contacts"));
+}
+
+TEST(FieldMaskTest, pathsIntoSameType_addUp) {
+    EXPECT_EQ(R"({"contacts":[{"address":{"domain":"example.com"}},{"address":{"domain":"example.org"}}],)"
+              R"("replyTo":{"domain":"example.com"}})",
+            masked(makeLetter(), "contacts.address,replyTo.domain"));
+}
+
+TEST(FieldMaskTest, unknownField_throwFieldMaskError) {
+    EXPECT_THROW(parseFieldMask<Letter>("id,unknown"), FieldMaskError);
+    EXPECT_THROW(parseFieldMask<Letter>("contacts.address.host"), FieldMaskError);
+    EXPECT_THROW(parseFieldMask<Letter>("contacts..kind"), FieldMaskError);
+}
+
+TEST(FieldMaskTest, subpathOfScalar_throwFieldMaskError) {
+    EXPECT_THROW(parseFieldMask<Letter>("subject.text"), FieldMaskError);
+}
+
+TEST(FieldMaskTest, sequenceOfStructs_parseItemType) {
+    const std::vector<Letter> value(2, makeLetter());
+    const FieldMask mask = parseFieldMask<std::vector<Letter>>("id");
+    const FieldMaskScope scope(mask);
+    EXPECT_EQ(R"([{"id":"42"},{"id":"42"}])", toJson(value).str());
+}
+
+TEST(FieldMaskTest, excludedGetter_notCalled) {
+    const Counted value;
+    Counted::calls = 0;
+    const FieldMask mask = parseFieldMask<Counted>("cheap");
+    const FieldMaskScope scope(mask);
+    EXPECT_EQ(R"({"cheap":1})", toJson(value).str());
+    EXPECT_EQ(0, Counted::calls);
+}
+
+TEST(FieldMaskTest, scope_restorePreviousMask) {
+    const Letter value = makeLetter();
+    const FieldMask outer = parseFieldMask<Letter>("id");
+    const FieldMaskScope outerScope(outer);
+    {
+        const FieldMask inner = parseFieldMask<Letter>("subject");
+        const FieldMaskScope innerScope(inner);
+        EXPECT_EQ(R"({"subject":"hello"})", toJson(value).str());
+    }
+    EXPECT_EQ(R"({"id":"42"})", toJson(value).str());
+    {
+        const FieldMaskScope emptyScope{FieldMask()};
+        EXPECT_EQ(masked(value, ""), toJson(value).str());
+    }
+}
+
+TEST(FieldMaskTest, protobufWriter_writeSelectedOnly) {
+    const Letter value = makeLetter();
+    std::string data;
+    {
+        const FieldMask mask = parseFieldMask<Letter>("id,contacts.kind");
+        const FieldMaskScope scope(mask);
+        data = toProtobuf(value);
+    }
+
+    const auto actual = yamail::data::deserialization::fromProtobuf<Letter>(data);
+    EXPECT_EQ("42", actual.id);
+    EXPECT_TRUE(actual.subject.empty());
+    ASSERT_EQ(2u, actual.contacts.size());
+    EXPECT_EQ("cc", actual.contacts[1].kind);
+    EXPECT_TRUE(actual.contacts[1].address.name.empty());
+    EXPECT_FALSE(actual.replyTo.is_initialized());
+    EXPECT_TRUE(actual.body.empty());
+}
+
+TEST(FieldMaskTest, jsonReader_readSelectedOnly) {
+    const FieldMask mask = parseFieldMask<Letter>("id,contacts.kind");
+    const FieldMaskScope scope(mask);
+    const auto actual = yamail::data::deserialization::fromJson<Letter>(
+            R"({"id":"1","contacts":[{"kind":"to"}]})");
+
+    EXPECT_EQ("1", actual.id);
+    ASSERT_EQ(1u, actual.contacts.size());
+    EXPECT_EQ("to", actual.contacts[0].kind);
+    EXPECT_TRUE(actual.body.empty());
+}
@@ -0,0 +1,90 @@
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <yamail/data/reflection/field_table.h>
+
+namespace {
+
+using yamail::data::reflection::members::FieldTable;
+using yamail::data::reflection::members::fieldTable;
+
+struct Message {
+    std::string id;
+    std::string subject;
+    long date;
+    bool seen;
+};
+
+class Recipient {
+public:
+    const std::string& type() const { return type_; }
+    void setType(const std::string& v) { type_ = v; }
+    const std::string& address() const { return address_; }
+    void setAddress(const std::string& v) { address_ = v; }
+private:
+    std::string type_;
+    std::string address_;
+};
+
+struct Empty {};
+
+} // namespace
+
+BOOST_FUSION_ADAPT_STRUCT(Message, id, subject, date, seen)
+
+BOOST_FUSION_ADAPT_ADT(Recipient,
+    (YR_GET_WITH_NAME(type), YR_SET_WITH_NAME(setType))
+    (YR_GET_WITH_NAME(address), YR_SET_WITH_NAME(setAddress))
+)
+
+BOOST_FUSION_ADAPT_STRUCT(Empty)
+
+namespace {
+
+TEST(FieldTableTest, structAttributes_findIndexInAdaptationOrder) {
+    const auto& table = fieldTable<Message>();
+
+    ASSERT_EQ(4u, table.size());
+    EXPECT_EQ(0u, table.find("id"));
+    EXPECT_EQ(1u, table.find("subject"));
+    EXPECT_EQ(2u, table.find("date"));
+    EXPECT_EQ(3u, table.find("seen"));
+    EXPECT_EQ("subject", table.name(1));
+}
+
+TEST(FieldTableTest, adtMethods_findIndexInAdaptationOrder) {
+    const auto& table = fieldTable<Recipient>();
+
+    ASSERT_EQ(2u, table.size());
+    EXPECT_EQ(0u, table.find("type"));
+    EXPECT_EQ(1u, table.find("address"));
+}
+
+TEST(FieldTableTest, unknownKey_returnNpos) {
+    const auto& table = fieldTable<Message>();
+
+    EXPECT_EQ(FieldTable::npos, table.find(""));
+    EXPECT_EQ(FieldTable::npos, table.find("i"));
+    EXPECT_EQ(FieldTable::npos, table.find("idx"));
+    EXPECT_EQ(FieldTable::npos, table.find("Subject"));
+    EXPECT_EQ(FieldTable::npos, fieldTable<Empty>().find("id"));
+}
+
+TEST(FieldTableTest, manyNames_findEveryIndex) {
+    std::vector<std::string> names;
+    for (std::size_t i = 0; i < 500; ++i) {
+        names.push_back("field_" + std::to_string(i));
+    }
+    const FieldTable table(names);
+
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        ASSERT_EQ(i, table.find(names[i])) << names[i];
+    }
+    EXPECT_EQ(FieldTable::npos, table.find("field_500"));
+}
+
+TEST(FieldTableTest, duplicateNames_throwException) {
+    EXPECT_THROW(FieldTable({"a", "b", "a"}), std::logic_error);
+}
+
+} // namespace
@@ -4,6 +4,7 @@
 #include <gtest/gtest.h>
 #include <yamail/data/serialization/json_writer.h>
 #include <yamail/data/deserialization/ptree_reader.h>
+#include <yamail/data/deserialization/json_reader.h>
 
 typedef std::map<std::string,std::string> StringMap;
 typedef std::pair<std::string, std::string> StringPair;
@@ -14,16 +15,16 @@ using namespace yamail::data::deserialization;
 
 class ClassWithMap {
 public:
-    void setTitle(const std::string& title) {
-        _title = title;
+    void setTitle(std::string title) {
+        _title = std::move(title);
     }
 
     const std::string& getTitle() const {
         return _title;
     }
 
-    void setDict(const StringMap& dict) {
-        _dict = dict;
+    void setDict(StringMap dict) {
+        _dict = std::move(dict);
     }
 
     const StringMap& getDict() const {
@@ -64,3 +65,117 @@ TEST(GetterSetterTest, deserializeStructWithMapFromJson_sameObject) {
     ASSERT_TRUE(obj == deserialized);
 }
 
+
+class ClassCountingInstances {
+public:
+    ClassCountingInstances() { ++instances; }
+    ClassCountingInstances(const ClassCountingInstances& other) : _title(other._title) { ++instances; }
+
+    const std::string& getTitle() const {
+        return _title;
+    }
+
+    void setTitle(std::string title) {
+        _title = std::move(title);
+    }
+
+    static int instances;
+
+private:
+    std::string _title;
+};
+
+int ClassCountingInstances::instances = 0;
+
+BOOST_FUSION_ADAPT_ADT(ClassCountingInstances,
+    (YR_GET_WITH_NAME(getTitle), YR_SET_WITH_NAME(setTitle))
+)
+
+TEST(GetterSetterTest, staticNames_knownWithoutObject) {
+    using Names = yamail::data::reflection::members::names::result_of::make_vector<ClassCountingInstances>::type;
+    using Name = typename std::decay<boost::fusion::result_of::value_at_c<Names, 0>::type>::type;
+
+    ASSERT_STREQ("getTitle", Name::call());
+}
+
+TEST(GetterSetterTest, serializeWithStaticNames_doNotConstructObject) {
+    ClassCountingInstances obj;
+    obj.setTitle("object");
+    const int instances = ClassCountingInstances::instances;
+
+    const auto json = toJson(obj).str();
+
+    ASSERT_EQ(R"json({"getTitle":"object"})json", json);
+    ASSERT_EQ(instances, ClassCountingInstances::instances);
+}
+
+struct CopyCounting {
+    CopyCounting() = default;
+    CopyCounting(const CopyCounting& other) : value(other.value) { ++copies; }
+    CopyCounting(CopyCounting&&) = default;
+    CopyCounting& operator=(const CopyCounting& other) { value = other.value; ++copies; return *this; }
+    CopyCounting& operator=(CopyCounting&&) = default;
+
+    std::string value;
+    static int copies;
+};
+
+int CopyCounting::copies = 0;
+
+BOOST_FUSION_ADAPT_STRUCT(CopyCounting,
+    (std::string, value)
+)
+
+class ClassWithReferenceGetter {
+public:
+    const CopyCounting& getCounting() const {
+        return _counting;
+    }
+
+    void setCounting(CopyCounting counting) {
+        _counting = std::move(counting);
+    }
+
+private:
+    CopyCounting _counting;
+};
+
+BOOST_FUSION_ADAPT_ADT(ClassWithReferenceGetter,
+    (YR_GET_WITH_NAME(getCounting), YR_SET_WITH_NAME(setCounting))
+)
+
+TEST(GetterSetterTest, serializeReferenceGetter_doNotCopyValue) {
+    ClassWithReferenceGetter obj;
+    CopyCounting counting;
+    counting.value = "value";
+    obj.setCounting(counting);
+    const int copies = CopyCounting::copies;
+
+    const auto json = toJson(obj).str();
+
+    ASSERT_EQ(R"json({"getCounting":{"value":"value"}})json", json);
+    ASSERT_EQ(copies, CopyCounting::copies);
+}
+
+TEST(GetterSetterTest, deserializeFromPtree_moveValueIntoSetter) {
+    std::istringstream jsonStream(R"json({"getCounting":{"value":"value"}})json");
+    boost::property_tree::ptree tree;
+    boost::property_tree::read_json(jsonStream, tree);
+    const int copies = CopyCounting::copies;
+
+    ClassWithReferenceGetter obj;
+    fromPtree(tree, obj);
+
+    ASSERT_EQ("value", obj.getCounting().value);
+    ASSERT_EQ(copies, CopyCounting::copies);
+}
+
+TEST(GetterSetterTest, deserializeFromJson_moveValueIntoSetter) {
+    const int copies = CopyCounting::copies;
+
+    ClassWithReferenceGetter obj;
+    fromJson(R"json({"getCounting":{"value":"value"}})json", obj);
+
+    ASSERT_EQ("value", obj.getCounting().value);
+    ASSERT_EQ(copies, CopyCounting::copies);
+}
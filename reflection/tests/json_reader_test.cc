@@ -155,3 +155,164 @@ using std::string;
 TEST_STRUCT_WITH_VALUE_WHEN_NULL(string)
 using vector_of_int = std::vector<int>;
 TEST_STRUCT_WITH_VALUE_WHEN_NULL(vector_of_int)
+
+typedef int IntArray[3];
+
+struct NestedStruct {
+    SimpleStruct simple;
+    std::vector<SimpleStruct> simples;
+    IntArray array;
+
+    bool operator==(const NestedStruct& other) const {
+        return simple == other.simple && simples == other.simples
+                && std::equal(array, array + 3, other.array);
+    }
+};
+
+BOOST_FUSION_ADAPT_STRUCT(NestedStruct,
+    (SimpleStruct, simple)
+    (std::vector<SimpleStruct>, simples)
+    (IntArray, array)
+)
+
+TEST(JsonReaderTest, NestedStruct_skipUnknownFields) {
+    const std::string json = R"json({
+        "unknown": {"a": [1, {"b": null}], "c": "d"},
+        "simple": {"str": "s1", "num": 1, "val": 0.5, "unknown": [1, 2]},
+        "simples": [{"str": "s2", "num": 2, "val": 1.5}, {"str": "s3", "num": 3, "val": 2.5}],
+        "array": [7, 8, 9]
+    })json";
+
+    const auto actual = yamail::data::deserialization::fromJson<NestedStruct>(json);
+
+    const NestedStruct expected = {
+        {"s1", 1, 0.5},
+        {{"s2", 2, 1.5}, {"s3", 3, 2.5}},
+        {7, 8, 9}
+    };
+
+    ASSERT_TRUE(expected == actual);
+}
+
+TEST(JsonReaderTest, missingField_throwException) {
+    const std::string json = R"json({"str": "blablabla", "num": 15})json";
+    EXPECT_THROW(yamail::data::deserialization::fromJson<SimpleStruct>(json),
+            yamail::data::deserialization::JsonReaderError);
+}
+
+TEST(JsonReaderTest, tooManyArrayItems_throwException) {
+    const std::string json = R"json({"simple": {"str": "", "num": 0, "val": 0},
+            "simples": [], "array": [1, 2, 3, 4]})json";
+    EXPECT_THROW(yamail::data::deserialization::fromJson<NestedStruct>(json),
+            yamail::data::deserialization::JsonReaderError);
+}
+
+TEST(JsonReaderTest, malformedJson_throwException) {
+    const std::string json = R"json({"str": "blablabla", "num": 15)json";
+    EXPECT_THROW(yamail::data::deserialization::fromJson<SimpleStruct>(json),
+            yamail::data::deserialization::JsonReaderError);
+}
+
+struct StructWithPointers {
+    std::unique_ptr<std::string> str;
+    boost::shared_ptr<SimpleStruct> simple;
+    boost::optional<SimpleStruct> optional;
+};
+
+BOOST_FUSION_ADAPT_STRUCT(StructWithPointers,
+    (std::unique_ptr<std::string>, str)
+    (boost::shared_ptr<SimpleStruct>, simple)
+    (boost::optional<SimpleStruct>, optional)
+)
+
+TEST(JsonReaderTest, StructWithPointers_resetPresentOnly) {
+    const std::string json = R"json({"simple": {"str": "s", "num": 1, "val": 2}})json";
+
+    const auto actual = yamail::data::deserialization::fromJson<StructWithPointers>(json);
+
+    ASSERT_FALSE(actual.str.get());
+    ASSERT_FALSE(actual.optional);
+    ASSERT_TRUE(actual.simple.get());
+    ASSERT_TRUE((SimpleStruct{"s", 1, 2.}) == *actual.simple);
+}
+
+class ClassWithSetters {
+public:
+    const std::string& getTitle() const { return title; }
+    void setTitle(const std::string& v) { title = v; }
+    const SimpleStruct& getSimple() const { return simple; }
+    void setSimple(const SimpleStruct& v) { simple = v; }
+
+    std::string title;
+    SimpleStruct simple;
+};
+
+BOOST_FUSION_ADAPT_ADT(ClassWithSetters,
+    (YR_GET_WITH_NAME(getTitle), YR_SET_WITH_NAME(setTitle))
+    (YR_GET_WITH_NAME(getSimple), YR_SET_WITH_NAME(setSimple))
+)
+
+TEST(JsonReaderTest, ClassWithSetters) {
+    const std::string json = R"json({"getSimple": {"str": "s", "num": 1, "val": 2}, "getTitle": "t"})json";
+
+    const auto actual = yamail::data::deserialization::fromJson<ClassWithSetters>(json);
+
+    ASSERT_EQ("t", actual.title);
+    ASSERT_TRUE((SimpleStruct{"s", 1, 2.}) == actual.simple);
+}
+
+namespace {
+
+using yamail::data::deserialization::JsonReaderError;
+using yamail::data::deserialization::json::StreamReader;
+
+std::vector<SimpleStruct> readByChunks(const std::string& key, const std::string& json, std::size_t chunk) {
+    std::vector<SimpleStruct> retval;
+    StreamReader<SimpleStruct> reader(key, [&](SimpleStruct&& v) { retval.push_back(std::move(v)); });
+    for (std::size_t i = 0; i < json.size(); i += chunk) {
+        reader.feed(json.data() + i, std::min(chunk, json.size() - i));
+    }
+    reader.complete();
+    return retval;
+}
+
+} // namespace
+
+TEST(JsonReaderTest, StreamReader_emitItemsOfTheKeyArray) {
+    const std::string json = R"json({"count": 2, "items": [{"str": "a", "num": 1, "val": 2},)json"
+            R"json({"str": "b", "num": 3, "val": 4}], "next": {"items": [1]}})json";
+    const std::vector<SimpleStruct> expected = {{"a", 1, 2.}, {"b", 3, 4.}};
+
+    for (std::size_t chunk = 1; chunk <= json.size(); ++chunk) {
+        ASSERT_TRUE(expected == readByChunks("items", json, chunk)) << "chunk size " << chunk;
+    }
+}
+
+TEST(JsonReaderTest, StreamReader_emitItemsOfTheRootArray) {
+    const std::string json = R"json([{"str": "a", "num": 1, "val": 2}, {"str": "b", "num": 3, "val": 4}])json";
+    const std::vector<SimpleStruct> expected = {{"a", 1, 2.}, {"b", 3, 4.}};
+
+    ASSERT_TRUE(expected == readByChunks("", json, 7));
+}
+
+TEST(JsonReaderTest, StreamReader_emitItemBeforeTheNextChunk) {
+    std::vector<int> items;
+    StreamReader<int> reader("items", [&](int&& v) { items.push_back(v); });
+
+    reader.feed(R"json({"items": [1, 2)json");
+    ASSERT_EQ(std::vector<int>({1}), items);
+    reader.feed(R"json(, 3])json");
+    ASSERT_EQ(std::vector<int>({1, 2, 3}), items);
+    reader.feed("}");
+    reader.complete();
+}
+
+TEST(JsonReaderTest, StreamReader_rootOfWrongType_throwException) {
+    ASSERT_THROW(readByChunks("", R"json({"items": []})json", 4), JsonReaderError);
+    ASSERT_THROW(readByChunks("items", "[]", 4), JsonReaderError);
+}
+
+TEST(JsonReaderTest, StreamReader_incompleteDocument_throwException) {
+    ASSERT_THROW(readByChunks("items", R"json({"items": [{"str": "a", "num": 1, "val": 2})json", 4),
+            JsonReaderError);
+}
@@ -0,0 +1,289 @@
+#include <array>
+#include <climits>
+#include <deque>
+#include <limits>
+#include <map>
+#include <vector>
+#include <gtest/gtest.h>
+#include <boost/property_tree/ptree.hpp>
+#include <yamail/data/serialization/json_writer.h>
+
+using namespace yamail::data::serialization;
+
+namespace {
+
+struct Inner {
+    std::string text;
+    std::vector<int> numbers;
+};
+
+struct Outer {
+    std::string id;
+    long date;
+    std::size_t size;
+    double rate;
+    float ratio;
+    bool flag;
+    boost::optional<int> missing;
+    boost::optional<std::string> present;
+    std::vector<Inner> items;
+    std::map<std::string, std::string> dict;
+    std::tuple<int, std::string> tuple;
+};
+
+struct OptionalFirst {
+    boost::optional<int> first;
+    boost::optional<int> second;
+    int third;
+};
+
+} // namespace
+
+BOOST_FUSION_ADAPT_STRUCT(Inner, text, numbers)
+
+BOOST_FUSION_ADAPT_STRUCT(Outer, id, date, size, rate, ratio, flag, missing, present, items, dict, tuple)
+
+BOOST_FUSION_ADAPT_STRUCT(OptionalFirst, first, second, third)
+
+namespace {
+
+Outer makeOuter() {
+    Outer retval;
+    retval.id = "id\t\"quoted\"/\\";
+    retval.date = -1460000000;
+    retval.size = 100500;
+    retval.rate = 0.1;
+    retval.ratio = 2.5f;
+    retval.flag = true;
+    retval.present = std::string("present");
+    retval.items = {{"first", {1, -2, 3}}, {"", {}}};
+    retval.dict = {{"key", "value"}, {"\x01", "\x1f\x7f"}};
+    retval.tuple = std::make_tuple(42, "\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82");
+    return retval;
+}
+
+template <typename T>
+void expectSameAsYajl(const T& value) {
+    const std::string json = toJson(value).str();
+    EXPECT_EQ(yajl::toJson(value).str(), json);
+    EXPECT_EQ(json.size(), jsonSize(value));
+}
+
+} // namespace
+
+TEST(JsonWriterTest, struct_sameAsYajl) {
+    expectSameAsYajl(makeOuter());
+}
+
+TEST(JsonWriterTest, structWithRootName_sameAsYajl) {
+    const Outer value = makeOuter();
+    const std::string json = toJson(value, "root").str();
+    EXPECT_EQ(yajl::toJson(value, "root").str(), json);
+    EXPECT_EQ(json.size(), jsonSize(value, "root"));
+}
+
+TEST(JsonWriterTest, structWithMissingFirstFields_sameAsYajl) {
+    OptionalFirst value;
+    value.third = 3;
+    expectSameAsYajl(value);
+    value.second = 2;
+    expectSameAsYajl(value);
+}
+
+TEST(JsonWriterTest, ptree_sameAsYajl) {
+    boost::property_tree::ptree tree;
+    tree.put("a.b", "c");
+    tree.put("a.d", 1);
+    boost::property_tree::ptree item;
+    item.put_value("item");
+    tree.get_child("a").add_child("e", boost::property_tree::ptree()).push_back(std::make_pair("", item));
+    expectSameAsYajl(tree);
+}
+
+TEST(JsonWriterTest, everyByteAtEveryOffset_sameAsYajl) {
+    for (std::size_t length = 1; length < 70; ++length) {
+        for (int c = 0; c < 256; ++c) {
+            std::vector<std::string> strings;
+            for (std::size_t offset = 0; offset < length; ++offset) {
+                std::string s(length, 'a');
+                s[offset] = static_cast<char>(c);
+                strings.push_back(s);
+            }
+            expectSameAsYajl(strings);
+        }
+    }
+}
+
+TEST(JsonWriterTest, allBytesString_sameAsYajl) {
+    std::string s;
+    for (int i = 0; i < 1024; ++i) {
+        s += static_cast<char>(i % 256);
+    }
+    expectSameAsYajl(std::vector<std::string>{s});
+}
+
+TEST(JsonWriterTest, numbers_sameAsYajl) {
+    expectSameAsYajl(std::vector<long>{0, 1, -1, 9, 10, -10, LONG_MAX, LONG_MIN});
+    expectSameAsYajl(std::vector<std::size_t>{0, 1, std::numeric_limits<std::size_t>::max()});
+    expectSameAsYajl(std::vector<double>{0.0, -0.0, 1.0, -1.5, 0.1, 1e21, 1e22, 1e-7, 123456789012345678.0,
+            std::numeric_limits<double>::max(), std::numeric_limits<double>::min(),
+            std::numeric_limits<double>::denorm_min()});
+    expectSameAsYajl(std::deque<bool>{true, false});
+}
+
+TEST(JsonWriterTest, numbers_writeShortestRoundTrip) {
+    EXPECT_EQ("[0.1,14.0,-0.0,1e+21,1e-07]", toJson(std::vector<double>{0.1, 14.0, -0.0, 1e21, 1e-7}).str());
+    EXPECT_EQ("[0.1,42.5,3.1415927]", toJson(std::vector<float>{0.1f, 42.5f, 3.14159265f}).str());
+}
+
+TEST(JsonWriterTest, unsignedAndShortIntegers_writeNumbers) {
+    EXPECT_EQ("[18446744073709551615]",
+            toJson(std::vector<unsigned long long>{std::numeric_limits<unsigned long long>::max()}).str());
+    EXPECT_EQ("[4294967295,65535,-32768]", toJson(std::make_tuple(
+            std::numeric_limits<unsigned>::max(), static_cast<unsigned short>(65535), short(-32768))).str());
+    EXPECT_EQ(std::to_string(std::numeric_limits<std::size_t>::max()),
+            toJson(std::numeric_limits<std::size_t>::max()).str());
+}
+
+TEST(JsonWriterTest, arithmeticRanges_sameAsYajl) {
+    std::vector<double> doubles;
+    std::vector<unsigned> unsigneds;
+    for (unsigned i = 0; i < 1000; ++i) {
+        doubles.push_back(i / 7.0 - 50);
+        unsigneds.push_back(i * 4294967u);
+    }
+    expectSameAsYajl(doubles);
+    expectSameAsYajl(unsigneds);
+    expectSameAsYajl(std::vector<int>{});
+    expectSameAsYajl(std::vector<std::vector<float>>{{}, {1.5f}, {0.1f, -2.0f}});
+    Inner inner{"text", {1, 2, 3}};
+    expectSameAsYajl(inner);
+    const long array[3] = {LONG_MIN, 0, LONG_MAX};
+    EXPECT_EQ("[-9223372036854775808,0,9223372036854775807]", toJson(array).str());
+    EXPECT_EQ(R"json({"root":[1,2]})json", toJson(std::array<short, 2>{{1, 2}}, "root").str());
+}
+
+TEST(JsonWriterTest, nan_throwsJsonError) {
+    EXPECT_THROW(toJson(std::vector<double>{std::numeric_limits<double>::quiet_NaN()}), JsonError);
+    EXPECT_THROW(toJson(std::vector<double>{std::numeric_limits<double>::infinity()}), JsonError);
+}
+
+TEST(JsonWriterTest, chunkedJson_concatenatedChunksSameAsYajl) {
+    std::vector<Inner> items = {{"first", {1}}, {"second\n", {2, 3}}};
+    const std::string rootName = "items";
+    auto chunks = toChunkedJson<Inner>(yamail::data::reflection::namedItemTag(rootName));
+
+    std::string json;
+    for (const auto& item : items) {
+        json += chunks(item).str();
+    }
+    json += chunks(boost::none).str();
+
+    EXPECT_EQ(yajl::toJson(items, rootName).str(), json);
+}
+
+TEST(JsonWriterTest, bufferRelease_movesTextOut) {
+    auto buffer = toJson(std::vector<int>{1, 2});
+    EXPECT_EQ("[1,2]", buffer.release());
+    EXPECT_EQ(0u, buffer.size());
+}
+
+TEST(JsonWriterTest, rope_sameAsToJson) {
+    Outer value = makeOuter();
+    value.id = std::string(3 * json::BlockPool::blockSize, 'x') + "\n";
+    EXPECT_EQ(toJson(value, "root").str(), toJsonRope(value, "root").str());
+}
+
+TEST(JsonWriterTest, ropeWithReferences_referencesOnlyLargeCleanStrings) {
+    std::vector<std::string> strings = {std::string(100, 'a'), std::string(100, 'b') + "\n", "c"};
+
+    const auto rope = toJsonRope(strings, "root", 100);
+
+    EXPECT_EQ(toJson(strings, "root").str(), rope.str());
+    std::size_t referenced = 0;
+    for (const auto& s : rope.segments()) {
+        for (const auto& string : strings) {
+            referenced += s.data == string.data();
+        }
+    }
+    EXPECT_EQ(1u, referenced);
+}
+
+struct TestConstBuffer {
+    TestConstBuffer(const void* data, std::size_t size) : data(static_cast<const char*>(data)), size(size) {}
+    const char* data;
+    std::size_t size;
+};
+
+TEST(JsonRopeTest, buffers_coverWholeText) {
+    json::BlockPool pool;
+    json::Rope rope(pool);
+    const std::string text(json::BlockPool::blockSize + 10, 'a');
+    rope += '[';
+    rope.append(text.data(), text.size());
+    rope += ']';
+
+    std::string joined;
+    for (const auto& b : rope.buffers<TestConstBuffer>()) {
+        joined.append(b.data, b.size);
+    }
+    EXPECT_EQ("[" + text + "]", joined);
+    EXPECT_EQ(joined.size(), rope.size());
+}
+
+TEST(JsonRopeTest, destroyedRope_returnsBlocksToPool) {
+    json::BlockPool pool;
+    {
+        json::Rope rope(pool);
+        const std::string text(2 * json::BlockPool::blockSize, 'a');
+        rope.append(text.data(), text.size());
+        json::Rope moved(std::move(rope));
+        EXPECT_EQ(0u, pool.freeBlocks());
+    }
+    EXPECT_EQ(2u, pool.freeBlocks());
+
+    json::Rope rope(pool);
+    rope += 'a';
+    EXPECT_EQ(1u, pool.freeBlocks());
+}
+
+TEST(JsonGeneratorTest, keyFragments_writeSeparatorsAndColons) {
+    const json::KeyFragment a("a"), b("b\"");
+    json::Generator gen;
+    gen.mapOpen();
+    gen.key(a);
+    gen.number(1);
+    gen.key(b);
+    gen.mapOpen();
+    gen.key(a);
+    gen.string("x");
+    gen.mapClose();
+    gen.mapClose();
+    EXPECT_EQ(R"json({"a":1,"b\"":{"a":"x"}})json", gen.buffer());
+}
+
+TEST(JsonGeneratorTest, keyInArray_throwsJsonError) {
+    json::Generator gen;
+    gen.arrayOpen();
+    EXPECT_THROW(gen.key(json::KeyFragment("a")), JsonError);
+}
+
+TEST(JsonGeneratorTest, valueAfterComplete_throwsJsonError) {
+    json::Generator gen;
+    gen.number(1);
+    EXPECT_THROW(gen.number(2), JsonError);
+}
+
+TEST(JsonGeneratorTest, nonStringKey_throwsJsonError) {
+    json::Generator gen;
+    gen.mapOpen();
+    EXPECT_THROW(gen.number(1), JsonError);
+}
+
+TEST(JsonGeneratorTest, tooDeep_throwsJsonError) {
+    json::Generator gen;
+    for (int i = 1; i < json::Generator::maxDepth; ++i) {
+        gen.arrayOpen();
+    }
+    EXPECT_THROW(gen.arrayOpen(), JsonError);
+}
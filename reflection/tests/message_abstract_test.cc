@@ -0,0 +1,42 @@
+#include <string>
+#include <gtest/gtest.h>
+#include <model/data/message.h>
+
+namespace {
+
+using model::abstract;
+using model::abstractSize;
+
+model::Message withBody(std::string body) {
+    model::Message retval;
+    retval.body = std::move(body);
+    return retval;
+}
+
+TEST(MessageAbstractTest, shortBody_returnWholeBody) {
+    EXPECT_EQ("", abstract(withBody("")));
+    EXPECT_EQ("short body", abstract(withBody("short body")));
+    const std::string exact(abstractSize, 'a');
+    EXPECT_EQ(exact, abstract(withBody(exact)));
+}
+
+TEST(MessageAbstractTest, longBody_cutAtLastSpaceWithinSize) {
+    const std::string body = std::string(100, 'a') + ' ' + std::string(300, 'b');
+    EXPECT_EQ(std::string(100, 'a'), abstract(withBody(body)));
+}
+
+TEST(MessageAbstractTest, bodyWithoutSpaces_cutAtSize) {
+    EXPECT_EQ(std::string(abstractSize, 'a'), abstract(withBody(std::string(abstractSize + 1, 'a'))));
+}
+
+TEST(MessageAbstractTest, spaceAtStartOnly_cutAtSize) {
+    const std::string body = ' ' + std::string(abstractSize * 2, 'a');
+    EXPECT_EQ(body.substr(0, abstractSize), abstract(withBody(body)));
+}
+
+TEST(MessageAbstractTest, spaceAtSize_cutBeforeIt) {
+    const std::string body = std::string(abstractSize, 'a') + ' ' + std::string(50, 'b');
+    EXPECT_EQ(std::string(abstractSize, 'a'), abstract(withBody(body)));
+}
+
+} // namespace
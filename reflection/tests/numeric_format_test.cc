@@ -0,0 +1,117 @@
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <gtest/gtest.h>
+#include <yamail/data/common/numeric_format.h>
+#include <yamail/data/common/numeric_translator.h>
+
+namespace {
+
+using namespace yamail::data::common;
+
+template <typename T>
+std::string format(T v) {
+    char buf[numeric::bufferSize];
+    return std::string(buf, formatNumber(buf, v));
+}
+
+TEST(NumericFormatTest, formatIntegers_writeDigits) {
+    EXPECT_EQ("0", format(0));
+    EXPECT_EQ("7", format(7));
+    EXPECT_EQ("-10", format(-10));
+    EXPECT_EQ("100500", format(100500));
+    EXPECT_EQ("-32768", format(short(-32768)));
+    EXPECT_EQ("65535", format(static_cast<unsigned short>(65535)));
+    EXPECT_EQ("-9223372036854775808", format(std::numeric_limits<long long>::min()));
+    EXPECT_EQ("9223372036854775807", format(std::numeric_limits<long long>::max()));
+    EXPECT_EQ("18446744073709551615", format(std::numeric_limits<unsigned long long>::max()));
+}
+
+TEST(NumericFormatTest, formatSizeT_neverNegative) {
+    EXPECT_EQ(std::to_string(std::numeric_limits<std::size_t>::max()),
+            format(std::numeric_limits<std::size_t>::max()));
+    EXPECT_EQ(std::to_string(std::size_t(1) << (sizeof(std::size_t) * 8 - 1)),
+            format(std::size_t(1) << (sizeof(std::size_t) * 8 - 1)));
+}
+
+TEST(NumericFormatTest, formatEveryIntegerWidth_sameAsToString) {
+    unsigned long long v = 1;
+    for (int i = 0; i < 20; ++i, v *= 10) {
+        EXPECT_EQ(std::to_string(v), format(v));
+        EXPECT_EQ(std::to_string(v - 1), format(v - 1));
+        EXPECT_EQ(std::to_string(-static_cast<long long>(v / 10) - 1), format(-static_cast<long long>(v / 10) - 1));
+    }
+}
+
+TEST(NumericFormatTest, formatDouble_writeShortestDigits) {
+    EXPECT_EQ("0", format(0.0));
+    EXPECT_EQ("-0", format(-0.0));
+    EXPECT_EQ("14", format(14.0));
+    EXPECT_EQ("-1.5", format(-1.5));
+    EXPECT_EQ("0.1", format(0.1));
+    EXPECT_EQ("0.3", format(0.3));
+    EXPECT_EQ("0.30000000000000004", format(0.1 + 0.2));
+    EXPECT_EQ("0.000001", format(1e-6));
+    EXPECT_EQ("1e-07", format(1e-7));
+    EXPECT_EQ("100000000000000000000", format(1e20));
+    EXPECT_EQ("1e+21", format(1e21));
+    EXPECT_EQ("123456789012345680", format(123456789012345678.0));
+    EXPECT_EQ("1.7976931348623157e+308", format(std::numeric_limits<double>::max()));
+    EXPECT_EQ("2.2250738585072014e-308", format(std::numeric_limits<double>::min()));
+    EXPECT_EQ("5e-324", format(std::numeric_limits<double>::denorm_min()));
+}
+
+TEST(NumericFormatTest, formatFloat_writeDigitsOfFloat) {
+    EXPECT_EQ("0.1", format(0.1f));
+    EXPECT_EQ("42.5", format(42.5f));
+    EXPECT_EQ("3.1415927", format(3.14159265f));
+    EXPECT_EQ("16777216", format(16777216.0f));
+    EXPECT_EQ("3.4028235e+38", format(std::numeric_limits<float>::max()));
+    EXPECT_EQ("1e-45", format(std::numeric_limits<float>::denorm_min()));
+}
+
+TEST(NumericFormatTest, formatNonFinite_writeNanAndInf) {
+    EXPECT_EQ("nan", format(std::numeric_limits<double>::quiet_NaN()));
+    EXPECT_EQ("inf", format(std::numeric_limits<double>::infinity()));
+    EXPECT_EQ("-inf", format(-std::numeric_limits<float>::infinity()));
+}
+
+template <typename T, typename Bits>
+void expectRoundTrip(std::size_t count) {
+    std::mt19937_64 random(42);
+    for (std::size_t i = 0; i < count; ++i) {
+        const Bits bits = static_cast<Bits>(random());
+        T v;
+        std::memcpy(&v, &bits, sizeof(v));
+        if (!std::isfinite(v)) {
+            continue;
+        }
+        const std::string text = format(v);
+        const boost::optional<T> parsed = NumericTranslator<T>().get_value(text);
+        ASSERT_TRUE(parsed) << text;
+        ASSERT_EQ(0, std::memcmp(&v, &*parsed, sizeof(v))) << text;
+    }
+}
+
+TEST(NumericFormatTest, formatRandomDoubles_readBackSameValue) {
+    expectRoundTrip<double, std::uint64_t>(100000);
+}
+
+TEST(NumericFormatTest, formatRandomFloats_readBackSameValue) {
+    expectRoundTrip<float, std::uint32_t>(100000);
+}
+
+TEST(NumericFormatTest, isNumber_excludeBoolAndCharacters) {
+    EXPECT_TRUE(numeric::is_number<int>::value);
+    EXPECT_TRUE(numeric::is_number<std::size_t>::value);
+    EXPECT_TRUE(numeric::is_number<float>::value);
+    EXPECT_FALSE(numeric::is_number<bool>::value);
+    EXPECT_FALSE(numeric::is_number<char>::value);
+    EXPECT_FALSE(numeric::is_number<unsigned char>::value);
+    EXPECT_FALSE(numeric::is_number<std::string>::value);
+}
+
+} // namespace
@@ -0,0 +1,83 @@
+#include <cmath>
+#include <limits>
+#include <gtest/gtest.h>
+#include <boost/optional/optional_io.hpp>
+#include <yamail/data/common/numeric_translator.h>
+
+namespace {
+
+using yamail::data::common::NumericTranslator;
+
+template <typename T>
+boost::optional<T> parse(const std::string& s) {
+    return NumericTranslator<T>().get_value(s);
+}
+
+TEST(NumericTranslatorTest, parseIntegers_returnValue) {
+    EXPECT_EQ(boost::optional<int>(42), parse<int>("42"));
+    EXPECT_EQ(boost::optional<int>(-42), parse<int>("-42"));
+    EXPECT_EQ(boost::optional<int>(42), parse<int>(" +42 "));
+    EXPECT_EQ(boost::optional<short>(-32768), parse<short>("-32768"));
+    EXPECT_EQ(boost::optional<unsigned char>(255), parse<unsigned char>("255"));
+    EXPECT_EQ(boost::optional<signed char>(-128), parse<signed char>("-128"));
+    EXPECT_EQ(boost::optional<long long>(std::numeric_limits<long long>::min()),
+            parse<long long>("-9223372036854775808"));
+    EXPECT_EQ(boost::optional<unsigned long long>(std::numeric_limits<unsigned long long>::max()),
+            parse<unsigned long long>("18446744073709551615"));
+}
+
+TEST(NumericTranslatorTest, parseIntegersOutOfRange_returnNone) {
+    EXPECT_FALSE(parse<short>("32768"));
+    EXPECT_FALSE(parse<unsigned char>("256"));
+    EXPECT_FALSE(parse<signed char>("-129"));
+    EXPECT_FALSE(parse<long long>("9223372036854775808"));
+    EXPECT_FALSE(parse<unsigned long long>("18446744073709551616"));
+    EXPECT_FALSE(parse<unsigned>("-1"));
+}
+
+TEST(NumericTranslatorTest, parseMalformedNumbers_returnNone) {
+    EXPECT_FALSE(parse<int>(""));
+    EXPECT_FALSE(parse<int>("-"));
+    EXPECT_FALSE(parse<int>("1.5"));
+    EXPECT_FALSE(parse<int>("12a"));
+    EXPECT_FALSE(parse<double>(""));
+    EXPECT_FALSE(parse<double>("1.5x"));
+    EXPECT_FALSE(parse<double>("1e"));
+    EXPECT_FALSE(parse<float>("abc"));
+}
+
+TEST(NumericTranslatorTest, parseBool_acceptDigitsAndWords) {
+    EXPECT_EQ(boost::optional<bool>(true), parse<bool>("1"));
+    EXPECT_EQ(boost::optional<bool>(false), parse<bool>("0"));
+    EXPECT_EQ(boost::optional<bool>(true), parse<bool>("true"));
+    EXPECT_EQ(boost::optional<bool>(false), parse<bool>("false"));
+    EXPECT_FALSE(parse<bool>("2"));
+}
+
+TEST(NumericTranslatorTest, parseChar_takeSingleCharacter) {
+    EXPECT_EQ(boost::optional<char>('a'), parse<char>("a"));
+    EXPECT_EQ(boost::optional<char>('7'), parse<char>("7"));
+    EXPECT_FALSE(parse<char>("ab"));
+    EXPECT_FALSE(parse<char>(""));
+}
+
+TEST(NumericTranslatorTest, parseFloatingPoint_sameAsStrtod) {
+    for (const char* s : {"0", "-0", "1.5", "-2.25", "0.1", "3.14159", "1e10", "1E-5", "123456.789e3",
+            "0.000001", "2.5e-300", "1.7976931348623157e308", "12345678901234567890123", "4.9e-324",
+            "0.30000000000000004", "9007199254740993", "1.00000000000000011102230246251565404236316680908203125"}) {
+        const auto actual = parse<double>(s);
+        ASSERT_TRUE(actual) << s;
+        EXPECT_EQ(std::strtod(s, nullptr), *actual) << s;
+        EXPECT_EQ(std::signbit(std::strtod(s, nullptr)), std::signbit(*actual)) << s;
+    }
+}
+
+TEST(NumericTranslatorTest, parseFloat_sameAsStrtof) {
+    for (const char* s : {"0.1", "1.5", "-3.4028235e38", "16777217", "1e-10", "0.333333333"}) {
+        const auto actual = parse<float>(s);
+        ASSERT_TRUE(actual) << s;
+        EXPECT_EQ(std::strtof(s, nullptr), *actual) << s;
+    }
+}
+
+} // namespace
@@ -0,0 +1,369 @@
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <gtest/gtest.h>
+#include <yamail/data/serialization/protobuf_writer.h>
+#include <yamail/data/deserialization/protobuf_reader.h>
+
+namespace {
+
+using namespace yamail::data;
+using serialization::toProtobuf;
+using serialization::ProtobufError;
+using deserialization::fromProtobuf;
+using deserialization::ProtobufReaderError;
+
+struct Point {
+    int x;
+    double y;
+};
+
+struct Sample {
+    int id;
+    std::string name;
+    std::vector<Point> points;
+    std::vector<int> packed;
+    std::map<std::string, int> counts;
+    std::tuple<int, std::string> tag;
+    boost::optional<std::string> note;
+    bool flag;
+    reflection::Blob data;
+};
+
+struct Text {
+    std::string value;
+};
+
+struct Envelope {
+    Text text;
+};
+
+class Owner {
+public:
+    const std::string& name() const { return name_; }
+    void setName(std::string name) { name_ = std::move(name); }
+    const Point& home() const { return home_; }
+    void setHome(Point home) { home_ = home; }
+
+private:
+    std::string name_;
+    Point home_{0, 0};
+};
+
+struct Matrix {
+    std::vector<std::vector<int>> rows;
+};
+
+struct Level {
+    std::uint8_t level;
+    std::int8_t delta;
+    char grade;
+    std::vector<std::uint8_t> steps;
+};
+
+struct Shape {
+    std::vector<Point> points;
+    std::vector<double> weights;
+    std::map<int, Point> byId;
+    std::unique_ptr<Point> origin;
+    boost::optional<std::tuple<unsigned, boost::optional<std::string>, float>> tag;
+    std::vector<std::string> labels;
+};
+
+} // namespace
+
+BOOST_FUSION_ADAPT_STRUCT(Point, x, y)
+YR_PROTOBUF_FIELDS(Point, 1, 2)
+
+BOOST_FUSION_ADAPT_STRUCT(Sample, id, name, points, packed, counts, tag, note, flag, data)
+YR_PROTOBUF_FIELDS(Sample, 1, 2, 3, 4, 5, 6, 7, 8, 16)
+
+BOOST_FUSION_ADAPT_STRUCT(Text, value)
+YR_PROTOBUF_FIELDS(Text, 1)
+
+BOOST_FUSION_ADAPT_STRUCT(Envelope, text)
+YR_PROTOBUF_FIELDS(Envelope, 3)
+
+BOOST_FUSION_ADAPT_ADT(Owner,
+    (YR_GET_WITH_NAME(name), YR_SET_WITH_NAME(setName))
+    (YR_GET_WITH_NAME(home), YR_SET_WITH_NAME(setHome))
+)
+YR_PROTOBUF_FIELDS(Owner, 2, 1)
+
+BOOST_FUSION_ADAPT_STRUCT(Matrix, rows)
+YR_PROTOBUF_FIELDS(Matrix, 1)
+
+BOOST_FUSION_ADAPT_STRUCT(Level, level, delta, grade, steps)
+YR_PROTOBUF_FIELDS(Level, 1, 2, 3, 4)
+
+BOOST_FUSION_ADAPT_STRUCT(Shape, points, weights, byId, origin, tag, labels)
+YR_PROTOBUF_FIELDS(Shape, 1, 2, 3, 4, 5, 100)
+
+namespace {
+
+std::string unhex(const std::string& s) {
+    std::string retval;
+    for (std::size_t i = 0; i + 1 < s.size(); i += 2) {
+        retval += static_cast<char>(std::stoi(s.substr(i, 2), nullptr, 16));
+    }
+    return retval;
+}
+
+bool operator==(const Point& lhs, const Point& rhs) {
+    return lhs.x == rhs.x && lhs.y == rhs.y;
+}
+
+std::string hex(const std::string& s) {
+    static const char digits[] = "0123456789abcdef";
+    std::string retval;
+    for (const char c : s) {
+        retval += digits[static_cast<unsigned char>(c) >> 4];
+        retval += digits[static_cast<unsigned char>(c) & 0xf];
+    }
+    return retval;
+}
+
+TEST(ProtobufWriterTest, scalars_writeVarintAndFixedFields) {
+    EXPECT_EQ("0801", hex(toProtobuf(1, 1)));
+    EXPECT_EQ("08ac02", hex(toProtobuf(300, 1)));
+    EXPECT_EQ("08ffffffffffffffffff01", hex(toProtobuf(-1, 1)));
+    EXPECT_EQ("08ffffffff0f", hex(toProtobuf(4294967295u, 1)));
+    EXPECT_EQ("1001", hex(toProtobuf(true, 2)));
+    EXPECT_EQ("1d0000803f", hex(toProtobuf(1.0f, 3)));
+    EXPECT_EQ("21000000000000f83f", hex(toProtobuf(1.5, 4)));
+    EXPECT_EQ("120774657374696e67", hex(toProtobuf(std::string("testing"), 2)));
+    EXPECT_EQ("820100", hex(toProtobuf(std::string(), 16)));
+}
+
+TEST(ProtobufWriterTest, smallIntegers_writeVarints) {
+    const Level l{200, -3, 'A', {1, 200}};
+    const std::string pb = toProtobuf(l);
+    EXPECT_EQ("08c801" "10fdffffffffffffffff01" "1841" "220301c801", hex(pb));
+    const auto r = fromProtobuf<Level>(pb);
+    EXPECT_EQ(200, r.level);
+    EXPECT_EQ(-3, r.delta);
+    EXPECT_EQ('A', r.grade);
+    EXPECT_EQ(l.steps, r.steps);
+}
+
+TEST(ProtobufWriterTest, struct_writeFieldsWithAnnotatedNumbers) {
+    EXPECT_EQ("080211000000000000f83f", hex(toProtobuf(Point{2, 1.5})));
+    Owner owner;
+    owner.setName("me");
+    owner.setHome({1, 0});
+    EXPECT_EQ("12026d65" "0a0b" "080111" "0000000000000000", hex(toProtobuf(owner)));
+}
+
+TEST(ProtobufWriterTest, nestedMessage_writeMultibyteLength) {
+    const Envelope e{{std::string(200, 'a')}};
+    const std::string pb = toProtobuf(e);
+    ASSERT_EQ(3u + 3u + 200u, pb.size());
+    EXPECT_EQ("1acb010ac801", hex(pb.substr(0, 6)));
+}
+
+TEST(ProtobufWriterTest, sample_writeRepeatedPackedMapAndTupleFields) {
+    Sample s;
+    s.id = 150;
+    s.name = "n";
+    s.points = {{1, 0}, {2, 0}};
+    s.packed = {3, 270, 86942};
+    s.counts = {{"a", 1}, {"b", 2}};
+    s.tag = std::make_tuple(7, "x");
+    s.flag = false;
+    s.data = reflection::Blob({1, 2});
+    EXPECT_EQ("089601"
+              "12016e"
+              "1a0b" "080111" "0000000000000000" "1a0b" "080211" "0000000000000000"
+              "2206" "03" "8e02" "9ea705"
+              "2a05" "0a0161" "1001" "2a05" "0a0162" "1002"
+              "3205" "0807" "120178"
+              "4000"
+              "8201" "020102",
+              hex(toProtobuf(s)));
+}
+
+TEST(ProtobufWriterTest, optionalAndEmptyRange_notWritten) {
+    Sample s{};
+    s.note = std::string("y");
+    EXPECT_EQ("0800" "1200" "3204" "0800" "1200" "3a0179" "4000" "820100", hex(toProtobuf(s)));
+}
+
+TEST(ProtobufWriterTest, rootSequence_writeRepeatedField) {
+    EXPECT_EQ("0a030a0161" "0a030a0162", hex(toProtobuf(std::vector<Text>{{"a"}, {"b"}}, 1)));
+    EXPECT_EQ("0a0161" "0a0162", hex(toProtobuf(std::vector<std::string>{"a", "b"}, 1)));
+    EXPECT_EQ("0a020102", hex(toProtobuf(std::vector<int>{1, 2}, 1)));
+}
+
+TEST(ProtobufWriterTest, nestedSequence_throwsException) {
+    EXPECT_THROW(toProtobuf(Matrix{{{1}, {2}}}), ProtobufError);
+}
+
+TEST(ProtobufReaderTest, sample_readWhatWriterWrites) {
+    Sample s;
+    s.id = -150;
+    s.name = "name";
+    s.points = {{1, 0.5}, {-2, 0}};
+    s.packed = {3, -270, 86942};
+    s.counts = {{"a", 1}, {"b", 2}};
+    s.tag = std::make_tuple(7, "x");
+    s.note = std::string("note");
+    s.flag = true;
+    s.data = reflection::Blob({1, 2, 255});
+    const auto r = fromProtobuf<Sample>(toProtobuf(s));
+    EXPECT_EQ(s.id, r.id);
+    EXPECT_EQ(s.name, r.name);
+    EXPECT_EQ(s.points, r.points);
+    EXPECT_EQ(s.packed, r.packed);
+    EXPECT_EQ(s.counts, r.counts);
+    EXPECT_TRUE(s.tag == r.tag);
+    EXPECT_TRUE(s.note == r.note);
+    EXPECT_EQ(s.flag, r.flag);
+    EXPECT_EQ(s.data, r.data);
+}
+
+TEST(ProtobufReaderTest, shape_readWhatWriterWrites) {
+    Shape s;
+    s.points = {{1, 2}};
+    s.weights = {0.5, -1.25};
+    s.byId = {{3, {3, 3}}, {-1, {1, 1}}};
+    s.origin.reset(new Point{5, 6});
+    s.tag = std::make_tuple(9u, boost::none, 1.5f);
+    s.labels = {"", std::string(300, 'l')};
+    const auto r = fromProtobuf<Shape>(toProtobuf(s));
+    EXPECT_EQ(s.points, r.points);
+    EXPECT_EQ(s.weights, r.weights);
+    EXPECT_EQ(s.byId, r.byId);
+    ASSERT_TRUE(r.origin);
+    EXPECT_EQ(*s.origin, *r.origin);
+    EXPECT_TRUE(s.tag == r.tag);
+    EXPECT_EQ(s.labels, r.labels);
+}
+
+TEST(ProtobufReaderTest, owner_readAdtMembersBySetters) {
+    Owner owner;
+    owner.setName("me");
+    owner.setHome({1, 2});
+    const auto r = fromProtobuf<Owner>(toProtobuf(owner));
+    EXPECT_EQ("me", r.name());
+    EXPECT_EQ(Point({1, 2}), r.home());
+}
+
+TEST(ProtobufReaderTest, mapOfAdt_readValuesBySetters) {
+    std::map<std::string, Owner> owners;
+    owners["b"].setName("bob");
+    owners["b"].setHome({1, 2});
+    owners["a"].setName("alice");
+    const auto r = fromProtobuf<std::map<std::string, Owner>>(toProtobuf(owners, 1), 1);
+    ASSERT_EQ(2u, r.size());
+    EXPECT_EQ("alice", r.at("a").name());
+    EXPECT_EQ("bob", r.at("b").name());
+    EXPECT_EQ(Point({1, 2}), r.at("b").home());
+}
+
+TEST(ProtobufReaderTest, mapWithRepeatedKey_lastEntryWins) {
+    std::map<std::string, Owner> first;
+    first["a"].setName("old");
+    first["b"].setName("bob");
+    std::map<std::string, Owner> second;
+    second["a"].setName("new");
+    const auto r = fromProtobuf<std::map<std::string, Owner>>(
+            toProtobuf(first, 1) + toProtobuf(second, 1), 1);
+    ASSERT_EQ(2u, r.size());
+    EXPECT_EQ("new", r.at("a").name());
+    EXPECT_EQ("bob", r.at("b").name());
+}
+
+TEST(ProtobufReaderTest, tupleWithEmptyPackedMember_keepLaterNumbers) {
+    using Tuple = std::tuple<std::vector<int>, std::string>;
+    const Tuple t(std::vector<int>(), "hi");
+    const std::string pb = toProtobuf(t, 1);
+    EXPECT_EQ("0a04" "12026869", hex(pb));
+    const auto r = fromProtobuf<Tuple>(pb, 1);
+    EXPECT_TRUE(std::get<0>(r).empty());
+    EXPECT_EQ("hi", std::get<1>(r));
+}
+
+TEST(ProtobufReaderTest, fieldsInAnyOrderWithUnknown_readByNumber) {
+    // y = 1.5, unknown varint 7, unknown bytes 9, unknown fixed32 10, x = 2,
+    // unknown fixed64 11
+    const auto p = fromProtobuf<Point>(unhex("11000000000000f83f" "3801" "4a03616263" "5500000000" "0802" "590000000000000000"));
+    EXPECT_EQ(Point({2, 1.5}), p);
+}
+
+TEST(ProtobufReaderTest, repeatedScalar_readPackedAndUnpacked) {
+    EXPECT_EQ(std::vector<int>({3, 270, 86942, 5}), fromProtobuf<Sample>(unhex("2206038e029ea705" "2005")).packed);
+    EXPECT_EQ(std::vector<int>({1, -1}), fromProtobuf<std::vector<int>>(unhex("0801" "08ffffffffffffffffff01"), 1));
+}
+
+TEST(ProtobufReaderTest, repeatedBool_readPacked) {
+    EXPECT_EQ(std::deque<bool>({true, false, true}), fromProtobuf<std::deque<bool>>(unhex("0a03010001"), 1));
+    EXPECT_EQ(std::deque<bool>({false, true, true}), fromProtobuf<std::deque<bool>>(unhex("0800" "0a020101"), 1));
+}
+
+TEST(ProtobufReaderTest, lastScalarWins) {
+    EXPECT_EQ(Point({2, 0}), fromProtobuf<Point>(unhex("0801" "0802")));
+}
+
+TEST(ProtobufReaderTest, missingFields_resetMembers) {
+    Sample s;
+    s.id = 1;
+    s.name = "stale";
+    s.points = {{1, 1}};
+    s.note = std::string("stale");
+    deserialization::fromProtobuf(unhex("12016e"), s);
+    EXPECT_EQ(0, s.id);
+    EXPECT_EQ("n", s.name);
+    EXPECT_TRUE(s.points.empty());
+    EXPECT_FALSE(s.note);
+}
+
+TEST(ProtobufReaderTest, rootField_readRepeatedMessages) {
+    const auto texts = fromProtobuf<std::vector<Text>>(unhex("0a030a0161" "1801" "0a030a0162"), 1);
+    ASSERT_EQ(2u, texts.size());
+    EXPECT_EQ("a", texts[0].value);
+    EXPECT_EQ("b", texts[1].value);
+}
+
+TEST(ProtobufReaderTest, malformedData_throwsException) {
+    EXPECT_THROW(fromProtobuf<Point>(unhex("08")), ProtobufReaderError);
+    EXPECT_THROW(fromProtobuf<Point>(unhex("0880")), ProtobufReaderError);
+    EXPECT_THROW(fromProtobuf<Point>(unhex("0a05616263")), ProtobufReaderError);
+    EXPECT_THROW(fromProtobuf<Point>(unhex("0b")), ProtobufReaderError);
+    EXPECT_THROW(fromProtobuf<Point>(unhex("0001")), ProtobufReaderError);
+    EXPECT_THROW(fromProtobuf<Point>(unhex("0880808080808080808080")), ProtobufReaderError);
+}
+
+TEST(ProtobufReaderTest, typeMismatch_throwsException) {
+    EXPECT_THROW(fromProtobuf<Point>(unhex("0a0161")), ProtobufReaderError);
+    EXPECT_THROW(fromProtobuf<Point>(unhex("1001")), ProtobufReaderError);
+    EXPECT_THROW(fromProtobuf<Text>(unhex("0801")), ProtobufReaderError);
+    EXPECT_THROW(fromProtobuf<Point>(unhex("0880808080807f")), ProtobufReaderError);
+    EXPECT_THROW(fromProtobuf<Matrix>(unhex("0a0101")), ProtobufReaderError);
+}
+
+TEST(ProtobufChunksTest, chunks_areDelimitedRecordsEndedByEmptyChunk) {
+    auto chunks = serialization::toChunkedProtobuf<Text>();
+    EXPECT_EQ("030a0161", hex(chunks(Text{"a"}).to_string()));
+    const auto large = chunks(Text{std::string(200, 'b')}).to_string();
+    EXPECT_EQ("cb010ac801", hex(large.substr(0, 5)));
+    EXPECT_EQ(205u, large.size());
+    EXPECT_TRUE(chunks(boost::none).empty());
+}
+
+TEST(ProtobufChunksTest, fromDelimitedProtobuf_readRecordsAndWaitForIncomplete) {
+    auto chunks = serialization::toChunkedProtobuf<Point>();
+    const std::string stream = chunks(Point{1, 0.5}).to_string() + chunks(Point{2, 1.5}).to_string();
+    Point p{0, 0};
+    const char* end = stream.data() + stream.size();
+    const char* next = deserialization::fromDelimitedProtobuf(stream.data(), end, p);
+    EXPECT_EQ(Point({1, 0.5}), p);
+    EXPECT_EQ(nullptr, deserialization::fromDelimitedProtobuf(next, end - 1, p));
+    EXPECT_EQ(nullptr, deserialization::fromDelimitedProtobuf(next, next, p));
+    EXPECT_EQ(end, deserialization::fromDelimitedProtobuf(next, end, p));
+    EXPECT_EQ(Point({2, 1.5}), p);
+}
+
+} // namespace
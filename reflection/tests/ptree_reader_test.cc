@@ -66,3 +66,66 @@ TEST(PtreeReaderTest, deserializeNull_setUninitializedOptional) {
 
     ASSERT_TRUE(expected == deserialized);
 }
+
+struct Point {
+    int x;
+    int y;
+    boost::optional<int> z;
+    std::string label;
+
+    bool operator==(const Point& other) const {
+        return x == other.x && y == other.y && z == other.z && label == other.label;
+    }
+};
+
+BOOST_FUSION_ADAPT_STRUCT(Point,
+    (int, x)
+    (int, y)
+    (boost::optional<int>, z)
+    (std::string, label)
+)
+
+typedef std::map<std::string, Point> PointMap;
+
+inline boost::property_tree::ptree readJson(const std::string& json) {
+    std::istringstream jsonStream(json);
+    boost::property_tree::ptree tree;
+    boost::property_tree::json_parser::read_json(jsonStream, tree);
+    return tree;
+}
+
+TEST(PtreeReaderTest, deserializeFieldsInAnyOrder_setAllFields) {
+    auto tree = readJson(R"json({"label": "a", "unknown": 0, "y": 2, "z": 3, "x": 1})json");
+
+    const auto deserialized = fromPtree<Point>(tree);
+
+    ASSERT_TRUE((Point{1, 2, 3, "a"}) == deserialized);
+}
+
+TEST(PtreeReaderTest, deserializeMissingOptionalField_setOtherFields) {
+    auto tree = readJson(R"json({"x": 1, "y": 2, "label": "a"})json");
+
+    const auto deserialized = fromPtree<Point>(tree);
+
+    ASSERT_TRUE((Point{1, 2, boost::none, "a"}) == deserialized);
+}
+
+TEST(PtreeReaderTest, deserializeMissingField_throwException) {
+    auto tree = readJson(R"json({"x": 1, "label": "a"})json");
+
+    ASSERT_THROW(fromPtree<Point>(tree), boost::property_tree::ptree_bad_path);
+}
+
+TEST(PtreeReaderTest, deserializeMapOfStructsInAnyOrder_setAllItems) {
+    auto tree = readJson(R"json({"c.c": {"x": 3, "y": 3, "label": "c"},)json"
+            R"json("a": {"label": "a", "y": 1, "x": 1}, "b": {"x": 2, "y": 2, "z": 2, "label": "b"}})json");
+
+    const auto deserialized = fromPtree<PointMap>(tree);
+
+    const PointMap expected = {
+        {"a", Point{1, 1, boost::none, "a"}},
+        {"b", Point{2, 2, 2, "b"}},
+        {"c.c", Point{3, 3, boost::none, "c"}}
+    };
+    ASSERT_TRUE(expected == deserialized);
+}